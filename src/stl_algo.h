@@ -0,0 +1,556 @@
+#ifndef __STL_ALGO_H__
+#define __STL_ALGO_H__
+
+#include "stl_alloc.h"
+#include "stl_trait.h"
+#include "stl_define.h"
+#include "stl_construct.h"
+
+#include <new>
+#include <thread>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <type_traits>
+
+namespace stl {
+
+/// range not larger than it is finished by insertion sort
+static const std::ptrdiff_t _sort_threshold = 16;
+/// range not smaller than it use radix sort for scalar keys
+static const std::ptrdiff_t _radix_sort_threshold = 1024;
+/// range not smaller than it is sorted by several threads
+static const std::ptrdiff_t _parallel_sort_threshold = 1 << 17;
+/// max thread count of parallel sort
+static const unsigned _parallel_sort_max_threads = 64;
+
+/**
+ * @brief insertion sort, for short range
+ * @param[in] first range begin
+ * @param[in] last range end
+ * @param[in] comp compare
+ * */
+template<typename RandomAccessIterator, typename Compare>
+inline void _insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Compare& comp) {
+  if (first == last)
+    return;
+  for (RandomAccessIterator cur = first + 1; cur != last; ++cur) {
+    auto value = std::move(*cur);
+    RandomAccessIterator hole = cur;
+    for (; hole != first && comp(value, *(hole - 1)); --hole)
+      *hole = std::move(*(hole - 1));
+    *hole = std::move(value);
+  }
+}
+
+/**
+ * @brief insertion sort without bound check, an element not greater than
+ *        every element of range must be before first
+ * @param[in] first range begin
+ * @param[in] last range end
+ * @param[in] comp compare
+ * */
+template<typename RandomAccessIterator, typename Compare>
+inline void _unguarded_insertion_sort(RandomAccessIterator first, RandomAccessIterator last,
+                                      Compare& comp) {
+  for (RandomAccessIterator cur = first; cur != last; ++cur) {
+    auto value = std::move(*cur);
+    RandomAccessIterator hole = cur;
+    for (; comp(value, *(hole - 1)); --hole)
+      *hole = std::move(*(hole - 1));
+    *hole = std::move(value);
+  }
+}
+
+/**
+ * @brief move median of first, middle and last - 1 to first
+ * @param[in] first range begin
+ * @param[in] last range end
+ * @param[in] comp compare
+ * */
+template<typename RandomAccessIterator, typename Compare>
+inline void _move_median_to_first(RandomAccessIterator first, RandomAccessIterator last,
+                                  Compare& comp) {
+  RandomAccessIterator a = first + 1;
+  RandomAccessIterator b = first + (last - first) / 2;
+  RandomAccessIterator c = last - 1;
+  if (comp(*a, *b)) {
+    if (comp(*b, *c))
+      std::iter_swap(first, b);
+    else if (comp(*a, *c))
+      std::iter_swap(first, c);
+    else
+      std::iter_swap(first, a);
+  } else if (comp(*a, *c)) {
+    std::iter_swap(first, a);
+  } else if (comp(*b, *c)) {
+    std::iter_swap(first, c);
+  } else {
+    std::iter_swap(first, b);
+  }
+}
+
+/**
+ * @brief partition around pivot at first, without bound check
+ * @param[in] first range begin, pivot
+ * @param[in] last range end
+ * @param[in] comp compare
+ * @return first element of right part
+ * */
+template<typename RandomAccessIterator, typename Compare>
+inline RandomAccessIterator _unguarded_partition(RandomAccessIterator first,
+                                                 RandomAccessIterator last, Compare& comp) {
+  RandomAccessIterator pivot = first;
+  RandomAccessIterator left = first + 1;
+  RandomAccessIterator right = last;
+  for (;;) {
+    while (comp(*left, *pivot))
+      ++left;
+    --right;
+    while (comp(*pivot, *right))
+      --right;
+    if (!(left < right))
+      return left;
+    std::iter_swap(left, right);
+    ++left;
+  }
+}
+
+/**
+ * @brief quick sort until range is short, heap sort when depth is used up
+ * @param[in] first range begin
+ * @param[in] last range end
+ * @param[in] depth left recursion depth
+ * @param[in] comp compare
+ * */
+template<typename RandomAccessIterator, typename Compare>
+inline void _introsort_loop(RandomAccessIterator first, RandomAccessIterator last, int depth,
+                            Compare& comp) {
+  while (last - first > _sort_threshold) {
+    if (depth == 0) {
+      std::make_heap(first, last, comp);
+      std::sort_heap(first, last, comp);
+      return;
+    }
+    depth--;
+    _move_median_to_first(first, last, comp);
+    RandomAccessIterator cut = _unguarded_partition(first, last, comp);
+    _introsort_loop(cut, last, depth, comp);
+    last = cut;
+  }
+}
+
+/**
+ * @brief introsort, quick sort with heap sort fallback, finished by insertion sort
+ * @param[in] first range begin
+ * @param[in] last range end
+ * @param[in] comp compare
+ * */
+template<typename RandomAccessIterator, typename Compare>
+inline void _introsort(RandomAccessIterator first, RandomAccessIterator last, Compare& comp) {
+  std::ptrdiff_t count = last - first;
+  if (count < 2)
+    return;
+  int depth = 0;
+  for (std::ptrdiff_t size = count; size > 1; size >>= 1)
+    depth += 2;
+  _introsort_loop(first, last, depth, comp);
+  // minimum is in first partition, which is not longer than threshold
+  if (count > _sort_threshold) {
+    _insertion_sort(first, first + _sort_threshold, comp);
+    _unguarded_insertion_sort(first + _sort_threshold, last, comp);
+  } else {
+    _insertion_sort(first, last, comp);
+  }
+}
+
+// radix key of scalar type, unsigned integer keep same order as value
+template<typename T, bool = std::is_floating_point<T>::value, bool = std::is_signed<T>::value>
+struct _radix_key {
+  typedef T type;
+  static type to(T value) { return value; }
+};
+
+// signed integer, flip sign bit
+template<typename T>
+struct _radix_key<T, false, true> {
+  typedef typename std::make_unsigned<T>::type type;
+  static type to(T value) {
+    return type(value) ^ (type(1) << (sizeof(T) * 8 - 1));
+  }
+};
+
+// float, flip all bits of negative, flip sign bit of positive
+template<typename T>
+struct _radix_key<T, true, true> {
+  typedef typename std::conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type type;
+  static type to(T value) {
+    type bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    type sign = type(1) << (sizeof(T) * 8 - 1);
+    return (bits & sign) ? ~bits : bits | sign;
+  }
+};
+
+/**
+ * @brief lsd radix sort by byte, scratch buffer from Alloc
+ *        all histograms are counted in one pass, byte shared by every key is skipped
+ * @param[in] first range begin
+ * @param[in] last range end
+ * */
+template<typename Alloc, typename T>
+inline void _radix_sort(T* first, T* last) {
+  typedef _radix_key<T> key;
+  const std::size_t passes = sizeof(T);
+  std::size_t count = last - first;
+  std::size_t histogram[sizeof(T)][256] = {};
+  for (T* cur = first; cur != last; ++cur) {
+    typename key::type bits = key::to(*cur);
+    for (std::size_t pass = 0; pass < passes; pass++)
+      histogram[pass][(bits >> (pass * 8)) & 0xff]++;
+  }
+  T* buffer = simple_alloc<T, Alloc>::allocate(count);
+  T* from = first;
+  T* to = buffer;
+  for (std::size_t pass = 0; pass < passes; pass++) {
+    std::size_t* bucket = histogram[pass];
+    if (bucket[(key::to(*first) >> (pass * 8)) & 0xff] == count)
+      continue;
+    std::size_t offset = 0;
+    for (std::size_t index = 0; index < 256; index++) {
+      std::size_t size = bucket[index];
+      bucket[index] = offset;
+      offset += size;
+    }
+    for (T* cur = from; cur != from + count; ++cur)
+      to[bucket[(key::to(*cur) >> (pass * 8)) & 0xff]++] = *cur;
+    std::swap(from, to);
+  }
+  if (from != first)
+    std::memcpy((void*)first, (const void*)from, count * sizeof(T));
+  simple_alloc<T, Alloc>::deallocate(buffer, count);
+}
+
+/**
+ * @brief run func(index) for index in [0, count), index 0 run on current thread,
+ *        tasks whose thread can not be created run on current thread too,
+ *        every task is finished before exception of the first failed task is rethrown
+ * @param[in] count task count
+ * @param[in] func task func
+ * */
+template<typename Func>
+inline void _parallel_for(unsigned count, Func func) {
+  std::thread threads[_parallel_sort_max_threads];
+  std::exception_ptr errors[_parallel_sort_max_threads];
+  auto task = [&func, &errors](unsigned index) {
+    try {
+      func(index);
+    } catch (...) {
+      errors[index] = std::current_exception();
+    }
+  };
+  unsigned started = 1;
+  try {
+    for (; started < count; started++)
+      threads[started] = std::thread(task, started);
+  } catch (...) {
+    // out of threads or memory, the rest run here
+  }
+  task(0u);
+  for (unsigned index = started; index < count; index++)
+    task(index);
+  for (unsigned index = 1; index < started; index++)
+    threads[index].join();
+  for (unsigned index = 0; index < count; index++) {
+    if (errors[index])
+      std::rethrow_exception(errors[index]);
+  }
+}
+
+/**
+ * @brief count of elements taken from a, when k smallest elements of a and b are merged
+ * @param[in] k merged element count
+ * @param[in] a first sorted range
+ * @param[in] a_count first range count
+ * @param[in] b second sorted range
+ * @param[in] b_count second range count
+ * @param[in] comp compare
+ * */
+template<typename T, typename Compare>
+inline std::size_t _merge_co_rank(std::size_t k, const T* a, std::size_t a_count, const T* b,
+                                  std::size_t b_count, Compare& comp) {
+  std::size_t low = k > b_count ? k - b_count : 0;
+  std::size_t high = k < a_count ? k : a_count;
+  while (low < high) {
+    std::size_t middle = low + (high - low) / 2;
+    std::size_t other = k - middle;
+    if (middle < a_count && other > 0 && !comp(b[other - 1], a[middle]))
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return low;
+}
+
+/**
+ * @brief move merge [a, a_last) and [b, b_last) to out, both bounds are checked,
+ *        so element out of part is never read
+ * @param[in] a first sorted range begin
+ * @param[in] a_last first sorted range end
+ * @param[in] b second sorted range begin
+ * @param[in] b_last second sorted range end
+ * @param[out] out merged range
+ * @param[in] comp compare
+ * */
+template<typename T, typename Compare>
+inline void _merge_part(T* a, T* a_last, T* b, T* b_last, T* out, Compare& comp) {
+  while (a != a_last && b != b_last) {
+    if (comp(*b, *a))
+      *out++ = std::move(*b++);
+    else
+      *out++ = std::move(*a++);
+  }
+  out = std::move(a, a_last, out);
+  std::move(b, b_last, out);
+}
+
+/**
+ * @brief merge sorted runs in rounds, every merge is split to all threads by co-rank
+ * @param[in] first range begin, hold moved-from elements
+ * @param[in] buffer scratch hold the runs, constructed
+ * @param[in] count element count
+ * @param[in] threads thread count, power of two, also run count
+ * @param[in] comp compare
+ * */
+template<typename T, typename Compare>
+inline void _parallel_merge_runs(T* first, T* buffer, std::size_t count, unsigned threads,
+                                 Compare& comp) {
+  T* from = buffer;
+  T* to = first;
+  for (unsigned runs = threads; runs > 1; runs /= 2) {
+    // threads / pairs parts per pair merge
+    unsigned pairs = runs / 2;
+    unsigned parts = threads / pairs;
+    // split points are searched before any thread moves elements out of from
+    std::size_t splits[_parallel_sort_max_threads];
+    for (unsigned index = 0; index < threads; index++) {
+      unsigned pair = index / parts;
+      unsigned part = index % parts;
+      std::size_t a_first = count * (2 * pair) / runs;
+      std::size_t b_first = count * (2 * pair + 1) / runs;
+      std::size_t b_last = count * (2 * pair + 2) / runs;
+      splits[index] = _merge_co_rank((b_last - a_first) * part / parts, from + a_first,
+                                     b_first - a_first, from + b_first, b_last - b_first, comp);
+    }
+    _parallel_for(threads, [=, &comp, &splits](unsigned index) {
+      Compare local = comp;
+      unsigned pair = index / parts;
+      unsigned part = index % parts;
+      std::size_t a_first = count * (2 * pair) / runs;
+      std::size_t b_first = count * (2 * pair + 1) / runs;
+      std::size_t b_last = count * (2 * pair + 2) / runs;
+      std::size_t total = b_last - a_first;
+      std::size_t out_first = total * part / parts;
+      std::size_t out_last = total * (part + 1) / parts;
+      std::size_t i_first = splits[index];
+      std::size_t i_last = part + 1 == parts ? b_first - a_first : splits[index + 1];
+      _merge_part(from + a_first + i_first, from + a_first + i_last,
+                  from + b_first + (out_first - i_first), from + b_first + (out_last - i_last),
+                  to + a_first + out_first, local);
+    });
+    std::swap(from, to);
+  }
+  if (from != first)
+    std::move(from, from + count, first);
+}
+
+/**
+ * @brief parallel merge sort, every thread sort one run by introsort,
+ *        then runs are merged in rounds, exception of any thread is rethrown here
+ *        after scratch is released, range then hold its elements in unspecified order
+ * @param[in] first range begin
+ * @param[in] last range end
+ * @param[in] threads thread count, power of two
+ * @param[in] comp compare
+ * */
+template<typename Alloc, typename T, typename Compare>
+inline void _parallel_sort(T* first, T* last, unsigned threads, Compare& comp) {
+  std::size_t count = last - first;
+  _parallel_for(threads, [=, &comp](unsigned index) {
+    Compare local = comp;
+    _introsort(first + count * index / threads, first + count * (index + 1) / threads, local);
+  });
+  // runs are moved to scratch, so both sides are always constructed
+  T* buffer = simple_alloc<T, Alloc>::allocate(count);
+  // thread which fail destroy its own part, parts of the others are destroyed here
+  bool built[_parallel_sort_max_threads] = {};
+  try {
+    _parallel_for(threads, [=, &built](unsigned index) {
+      T* part_first = first + count * index / threads;
+      T* part_last = first + count * (index + 1) / threads;
+      T* out_first = buffer + (part_first - first);
+      T* out = out_first;
+      try {
+        for (; part_first != part_last; ++part_first, ++out)
+          new ((void*)out) T(std::move(*part_first));
+      } catch (...) {
+        stl::destroy(out_first, out);
+        throw;
+      }
+      built[index] = true;
+    });
+  } catch (...) {
+    for (unsigned index = 0; index < threads; index++) {
+      if (built[index])
+        stl::destroy(buffer + count * index / threads, buffer + count * (index + 1) / threads);
+    }
+    simple_alloc<T, Alloc>::deallocate(buffer, count);
+    throw;
+  }
+  // merge only move assign between constructed elements, so on exception every
+  // element is still valid, range hold the elements in unspecified order
+  try {
+    _parallel_merge_runs(first, buffer, count, threads, comp);
+  } catch (...) {
+    stl::destroy(buffer, buffer + count);
+    simple_alloc<T, Alloc>::deallocate(buffer, count);
+    throw;
+  }
+  stl::destroy(buffer, buffer + count);
+  simple_alloc<T, Alloc>::deallocate(buffer, count);
+}
+
+/**
+ * @brief thread count for parallel sort, power of two
+ * @param[in] count element count
+ * */
+inline unsigned _parallel_sort_threads(std::ptrdiff_t count) {
+  if (count < _parallel_sort_threshold)
+    return 1;
+  unsigned hardware = std::thread::hardware_concurrency();
+  std::ptrdiff_t limit = count / (_parallel_sort_threshold / 2);
+  unsigned threads = 1;
+  while (threads * 2 <= hardware && threads * 2 <= limit && threads * 2 <= _parallel_sort_max_threads)
+    threads *= 2;
+  return threads;
+}
+
+/**
+ * @brief sort pointer range, comparison sort
+ * @param[in] first range begin
+ * @param[in] last range end
+ * @param[in] comp compare
+ * @param[in] false_type not radix sortable
+ * */
+template<typename Alloc, typename T, typename Compare>
+inline void _sort_ptr(T* first, T* last, Compare& comp, std::false_type) {
+  unsigned threads = _parallel_sort_threads(last - first);
+  if (threads > 1)
+    return _parallel_sort<Alloc>(first, last, threads, comp);
+  _introsort(first, last, comp);
+}
+
+/**
+ * @brief sort pointer range of scalar keys in ascending order, radix sort large range
+ * @param[in] first range begin
+ * @param[in] last range end
+ * @param[in] comp compare
+ * @param[in] true_type radix sortable
+ * */
+template<typename Alloc, typename T, typename Compare>
+inline void _sort_ptr(T* first, T* last, Compare& comp, std::true_type) {
+  if (last - first >= _radix_sort_threshold)
+    return _radix_sort<Alloc>(first, last);
+  _introsort(first, last, comp);
+}
+
+/**
+ * @brief sort random access range
+ * @param[in] first range begin
+ * @param[in] last range end
+ * @param[in] comp compare
+ * @param[in] random_access_iterator_tag iterator category
+ * */
+template<typename Alloc, typename RandomAccessIterator, typename Compare>
+inline void _sort(RandomAccessIterator first, RandomAccessIterator last, Compare& comp,
+                  random_access_iterator_tag) {
+  _introsort(first, last, comp);
+}
+
+/**
+ * @brief sort pointer range, parallel or radix sort is allowed
+ * @param[in] first range begin
+ * @param[in] last range end
+ * @param[in] comp compare
+ * @param[in] random_access_iterator_tag iterator category
+ * */
+template<typename Alloc, typename T, typename Compare>
+inline void _sort(T* first, T* last, Compare& comp, random_access_iterator_tag) {
+  // radix key is at most 64 bits, so long double and 128 bit integers use compare sort
+  typedef std::integral_constant<bool, (std::is_integral<T>::value ||
+                                        std::is_floating_point<T>::value) &&
+                                 sizeof(T) <= sizeof(std::uint64_t) &&
+                                 !std::is_same<T, bool>::value &&
+                                 std::is_same<Compare, std::less<T>>::value> radix_sortable;
+  _sort_ptr<Alloc>(first, last, comp, radix_sortable());
+}
+
+/**
+ * @brief sort forward range, elements are sorted in scratch buffer then copied back
+ * @param[in] first range begin
+ * @param[in] last range end
+ * @param[in] comp compare
+ * @param[in] forward_iterator_tag iterator category
+ * */
+template<typename Alloc, typename ForwardIterator, typename Compare>
+inline void _sort(ForwardIterator first, ForwardIterator last, Compare& comp,
+                  forward_iterator_tag) {
+  typedef typename iterator_trait<ForwardIterator>::value_type value_type;
+  std::size_t count = 0;
+  for (ForwardIterator cur = first; cur != last; ++cur)
+    count++;
+  value_type* buffer = simple_alloc<value_type, Alloc>::allocate(count);
+  value_type* out = buffer;
+  for (ForwardIterator cur = first; cur != last; ++cur, ++out)
+    new ((void*)out) value_type(std::move(*cur));
+  _sort<Alloc>(buffer, buffer + count, comp, random_access_iterator_tag());
+  out = buffer;
+  for (ForwardIterator cur = first; cur != last; ++cur, ++out)
+    *cur = std::move(*out);
+  stl::destroy(buffer, buffer + count);
+  simple_alloc<value_type, Alloc>::deallocate(buffer, count);
+}
+
+/**
+ * @brief sort range by comp, not stable
+ *        pointer range of scalar keys with default order use radix sort,
+ *        large pointer range use parallel merge sort, others use introsort,
+ *        forward range is sorted in scratch buffer
+ * @param[in] first range begin
+ * @param[in] last range end
+ * @param[in] comp compare
+ * */
+template<typename ForwardIterator, typename Compare>
+inline void sort(ForwardIterator first, ForwardIterator last, Compare comp) {
+  typedef typename iterator_trait<ForwardIterator>::iterator_category category;
+  _sort<alloc>(first, last, comp, category());
+}
+
+/**
+ * @brief sort range in ascending order, not stable
+ * @param[in] first range begin
+ * @param[in] last range end
+ * */
+template<typename ForwardIterator>
+inline void sort(ForwardIterator first, ForwardIterator last) {
+  typedef typename iterator_trait<ForwardIterator>::value_type value_type;
+  stl::sort(first, last, std::less<value_type>());
+}
+
+}
+
+#endif // !__STL_ALGO_H__
@@ -0,0 +1,361 @@
+#ifndef __STL_ALGOBASE_H__
+#define __STL_ALGOBASE_H__
+
+#include "stl_define.h"
+#include "stl_trait.h"
+
+#include <cstring>
+#include <cstddef>
+#include <utility>
+
+namespace stl {
+
+/**
+ * @brief copy input iterator one by one
+ * @param[in] begin iterator begin
+ * @param[in] end iterator end
+ * @param[out] result iterator result
+ * @param[in] input_iterator_tag iterator category
+ * */
+template<typename InputIterator, typename OutputIterator>
+inline OutputIterator _copy(InputIterator begin, InputIterator end, OutputIterator result,
+                            input_iterator_tag) {
+  for (; begin != end; ++begin, ++result)
+    *result = *begin;
+  return result;
+}
+
+/**
+ * @brief copy random access iterator, loop by count
+ * @param[in] begin iterator begin
+ * @param[in] end iterator end
+ * @param[out] result iterator result
+ * @param[in] random_access_iterator_tag iterator category
+ * */
+template<typename RandomAccessIterator, typename OutputIterator>
+inline OutputIterator _copy(RandomAccessIterator begin, RandomAccessIterator end,
+                            OutputIterator result, random_access_iterator_tag) {
+  for (auto count = end - begin; count > 0; --count, ++begin, ++result)
+    *result = *begin;
+  return result;
+}
+
+/**
+ * @brief copy trivial data between pointers, use memmove
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result
+ * @param[in] true_type trivial assignment
+ * */
+template<typename T>
+inline T* _copy_ptr(const T* begin, const T* end, T* result, __true_type) {
+  std::size_t count = end - begin;
+  if (count > 0)
+    std::memmove((void*)result, (const void*)begin, count * sizeof(T));
+  return result + count;
+}
+
+/**
+ * @brief copy non trivial data between pointers
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result
+ * @param[in] false_type non trivial assignment
+ * */
+template<typename T>
+inline T* _copy_ptr(const T* begin, const T* end, T* result, __false_type) {
+  return _copy(begin, end, result, random_access_iterator_tag());
+}
+
+/**
+ * @brief copy [begin, end) to result, result must not be in [begin, end)
+ * @param[in] begin iterator begin
+ * @param[in] end iterator end
+ * @param[out] result iterator result
+ * */
+template<typename InputIterator, typename OutputIterator>
+inline OutputIterator copy(InputIterator begin, InputIterator end, OutputIterator result) {
+  typedef typename iterator_trait<InputIterator>::iterator_category category;
+  return _copy(begin, end, result, category());
+}
+
+/**
+ * @brief copy specialization for pointer
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result
+ * */
+template<typename T>
+inline T* copy(const T* begin, const T* end, T* result) {
+  typedef typename __type_traits<T>::has_trivial_assignment_operator trivial_assign;
+  return _copy_ptr(begin, end, result, trivial_assign());
+}
+
+/**
+ * @brief copy specialization for pointer
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result
+ * */
+template<typename T>
+inline T* copy(T* begin, T* end, T* result) {
+  return stl::copy((const T*)begin, (const T*)end, result);
+}
+
+/**
+ * @brief copy bidirectional iterator backward one by one
+ * @param[in] begin iterator begin
+ * @param[in] end iterator end
+ * @param[out] result iterator result end
+ * @param[in] bidirectional_iterator_tag iterator category
+ * */
+template<typename BidirectionalIterator1, typename BidirectionalIterator2>
+inline BidirectionalIterator2 _copy_backward(BidirectionalIterator1 begin, BidirectionalIterator1 end,
+                                             BidirectionalIterator2 result,
+                                             bidirectional_iterator_tag) {
+  while (begin != end)
+    *--result = *--end;
+  return result;
+}
+
+/**
+ * @brief copy random access iterator backward, loop by count
+ * @param[in] begin iterator begin
+ * @param[in] end iterator end
+ * @param[out] result iterator result end
+ * @param[in] random_access_iterator_tag iterator category
+ * */
+template<typename RandomAccessIterator, typename BidirectionalIterator>
+inline BidirectionalIterator _copy_backward(RandomAccessIterator begin, RandomAccessIterator end,
+                                            BidirectionalIterator result,
+                                            random_access_iterator_tag) {
+  for (auto count = end - begin; count > 0; --count)
+    *--result = *--end;
+  return result;
+}
+
+/**
+ * @brief copy trivial data backward between pointers, use memmove
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result end
+ * @param[in] true_type trivial assignment
+ * */
+template<typename T>
+inline T* _copy_backward_ptr(const T* begin, const T* end, T* result, __true_type) {
+  std::size_t count = end - begin;
+  if (count > 0)
+    std::memmove((void*)(result - count), (const void*)begin, count * sizeof(T));
+  return result - count;
+}
+
+/**
+ * @brief copy non trivial data backward between pointers
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result end
+ * @param[in] false_type non trivial assignment
+ * */
+template<typename T>
+inline T* _copy_backward_ptr(const T* begin, const T* end, T* result, __false_type) {
+  return _copy_backward(begin, end, result, random_access_iterator_tag());
+}
+
+/**
+ * @brief copy [begin, end) to range end at result, result must not be in (begin, end]
+ * @param[in] begin iterator begin
+ * @param[in] end iterator end
+ * @param[out] result iterator result end
+ * */
+template<typename BidirectionalIterator1, typename BidirectionalIterator2>
+inline BidirectionalIterator2 copy_backward(BidirectionalIterator1 begin, BidirectionalIterator1 end,
+                                            BidirectionalIterator2 result) {
+  typedef typename iterator_trait<BidirectionalIterator1>::iterator_category category;
+  return _copy_backward(begin, end, result, category());
+}
+
+/**
+ * @brief copy backward specialization for pointer
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result end
+ * */
+template<typename T>
+inline T* copy_backward(const T* begin, const T* end, T* result) {
+  typedef typename __type_traits<T>::has_trivial_assignment_operator trivial_assign;
+  return _copy_backward_ptr(begin, end, result, trivial_assign());
+}
+
+/**
+ * @brief copy backward specialization for pointer
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result end
+ * */
+template<typename T>
+inline T* copy_backward(T* begin, T* end, T* result) {
+  return stl::copy_backward((const T*)begin, (const T*)end, result);
+}
+
+/**
+ * @brief move input iterator one by one
+ * @param[in] begin iterator begin
+ * @param[in] end iterator end
+ * @param[out] result iterator result
+ * @param[in] input_iterator_tag iterator category
+ * */
+template<typename InputIterator, typename OutputIterator>
+inline OutputIterator _move(InputIterator begin, InputIterator end, OutputIterator result,
+                            input_iterator_tag) {
+  for (; begin != end; ++begin, ++result)
+    *result = std::move(*begin);
+  return result;
+}
+
+/**
+ * @brief move random access iterator, loop by count
+ * @param[in] begin iterator begin
+ * @param[in] end iterator end
+ * @param[out] result iterator result
+ * @param[in] random_access_iterator_tag iterator category
+ * */
+template<typename RandomAccessIterator, typename OutputIterator>
+inline OutputIterator _move(RandomAccessIterator begin, RandomAccessIterator end,
+                            OutputIterator result, random_access_iterator_tag) {
+  for (auto count = end - begin; count > 0; --count, ++begin, ++result)
+    *result = std::move(*begin);
+  return result;
+}
+
+/**
+ * @brief move non trivial data between pointers
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result
+ * @param[in] false_type non trivial assignment
+ * */
+template<typename T>
+inline T* _move_ptr(T* begin, T* end, T* result, __false_type) {
+  return _move(begin, end, result, random_access_iterator_tag());
+}
+
+/**
+ * @brief move trivial data between pointers, same as copy
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result
+ * @param[in] true_type trivial assignment
+ * */
+template<typename T>
+inline T* _move_ptr(T* begin, T* end, T* result, __true_type) {
+  return _copy_ptr((const T*)begin, (const T*)end, result, __true_type());
+}
+
+/**
+ * @brief move [begin, end) to result, result must not be in [begin, end)
+ * @param[in] begin iterator begin
+ * @param[in] end iterator end
+ * @param[out] result iterator result
+ * */
+template<typename InputIterator, typename OutputIterator>
+inline OutputIterator move(InputIterator begin, InputIterator end, OutputIterator result) {
+  typedef typename iterator_trait<InputIterator>::iterator_category category;
+  return _move(begin, end, result, category());
+}
+
+/**
+ * @brief move specialization for pointer
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result
+ * */
+template<typename T>
+inline T* move(T* begin, T* end, T* result) {
+  typedef typename __type_traits<T>::has_trivial_assignment_operator trivial_assign;
+  return _move_ptr(begin, end, result, trivial_assign());
+}
+
+/**
+ * @brief move bidirectional iterator backward one by one
+ * @param[in] begin iterator begin
+ * @param[in] end iterator end
+ * @param[out] result iterator result end
+ * @param[in] bidirectional_iterator_tag iterator category
+ * */
+template<typename BidirectionalIterator1, typename BidirectionalIterator2>
+inline BidirectionalIterator2 _move_backward(BidirectionalIterator1 begin, BidirectionalIterator1 end,
+                                             BidirectionalIterator2 result,
+                                             bidirectional_iterator_tag) {
+  while (begin != end)
+    *--result = std::move(*--end);
+  return result;
+}
+
+/**
+ * @brief move random access iterator backward, loop by count
+ * @param[in] begin iterator begin
+ * @param[in] end iterator end
+ * @param[out] result iterator result end
+ * @param[in] random_access_iterator_tag iterator category
+ * */
+template<typename RandomAccessIterator, typename BidirectionalIterator>
+inline BidirectionalIterator _move_backward(RandomAccessIterator begin, RandomAccessIterator end,
+                                            BidirectionalIterator result,
+                                            random_access_iterator_tag) {
+  for (auto count = end - begin; count > 0; --count)
+    *--result = std::move(*--end);
+  return result;
+}
+
+/**
+ * @brief move non trivial data backward between pointers
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result end
+ * @param[in] false_type non trivial assignment
+ * */
+template<typename T>
+inline T* _move_backward_ptr(T* begin, T* end, T* result, __false_type) {
+  return _move_backward(begin, end, result, random_access_iterator_tag());
+}
+
+/**
+ * @brief move trivial data backward between pointers, same as copy backward
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result end
+ * @param[in] true_type trivial assignment
+ * */
+template<typename T>
+inline T* _move_backward_ptr(T* begin, T* end, T* result, __true_type) {
+  return _copy_backward_ptr((const T*)begin, (const T*)end, result, __true_type());
+}
+
+/**
+ * @brief move [begin, end) to range end at result, result must not be in (begin, end]
+ * @param[in] begin iterator begin
+ * @param[in] end iterator end
+ * @param[out] result iterator result end
+ * */
+template<typename BidirectionalIterator1, typename BidirectionalIterator2>
+inline BidirectionalIterator2 move_backward(BidirectionalIterator1 begin, BidirectionalIterator1 end,
+                                            BidirectionalIterator2 result) {
+  typedef typename iterator_trait<BidirectionalIterator1>::iterator_category category;
+  return _move_backward(begin, end, result, category());
+}
+
+/**
+ * @brief move backward specialization for pointer
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result end
+ * */
+template<typename T>
+inline T* move_backward(T* begin, T* end, T* result) {
+  typedef typename __type_traits<T>::has_trivial_assignment_operator trivial_assign;
+  return _move_backward_ptr(begin, end, result, trivial_assign());
+}
+
+}
+
+#endif // !__STL_ALGOBASE_H__
@@ -2,18 +2,43 @@
 #define __STL_ALLOC_H__
 
 #include "stl_construct.h"
+#include "stl_alloc_trace.h"
+#include "stl_alloc_sample.h"
 
 #include <new>
 #include <cstdlib>
+#include <cstring>
+#include <mutex>
 #include <cstddef>
+#include <type_traits>
+
+// system allocator under malloc_alloc, a malloc replacement built on the pool
+// must define them to libc internal entries, so pool chunks do not recurse into it
+#ifndef __STL_SYSTEM_MALLOC
+#define __STL_SYSTEM_MALLOC(size) std::malloc(size)
+#define __STL_SYSTEM_FREE(ptr) std::free(ptr)
+#define __STL_SYSTEM_REALLOC(ptr, size) std::realloc(ptr, size)
+#define __STL_SYSTEM_ALIGNED_ALLOC(alignment, size) std::aligned_alloc(alignment, size)
+#endif
 
 namespace stl {
 
+/// cache line size, use to avoid false sharing and for aligned simd load
+static const std::size_t cache_line_size = 64;
+
 template<int insl> 
 class _malloc_alloc_template {
 public:
   /// define malloc oom handler
   typedef void(*_malloc_alloc_handler)();
+  /// define release handler in oom chain, return released bytes
+  typedef std::size_t(*_malloc_release_handler)(void* context);
+  /// priority of pool release handler, smaller run first
+  static constexpr int pool_release_priority = 0;
+  /// suggested priority of application cache release handler
+  static constexpr int cache_release_priority = 100;
+  /// malloc result align
+  static constexpr std::size_t align_size = alignof(std::max_align_t);
 
 public:
   /**
@@ -22,10 +47,11 @@ public:
    * */
   static void* allocate(std::size_t size) {
     // try to malloc memory
-    void* ptr = std::malloc(size);
+    void* ptr = __STL_SYSTEM_MALLOC(size);
     // call oom to remalloc memory
     if (ptr == nullptr)
       ptr = oom_malloc(size);
+    __STL_SAMPLE_ALLOCATE(ptr, size);
     return ptr;
   }
 
@@ -35,7 +61,39 @@ public:
    * @param[in] size memory size
    * */
   static void deallocate(void* ptr, std::size_t /* n*/) {
-    std::free(ptr);
+    __STL_SAMPLE_DEALLOCATE(ptr);
+    __STL_SYSTEM_FREE(ptr);
+  }
+
+  /**
+   * @brief allocate aligned memory
+   * @param[in] size memory size
+   * @param[in] alignment memory align, must be power of two
+   * */
+  static void* allocate(std::size_t size, std::size_t alignment) {
+    if (alignment < sizeof(void*))
+      alignment = sizeof(void*);
+    // round up below must not wrap to small size
+    if (size > std::size_t(-1) - alignment)
+      throw std::bad_alloc{};
+    // aligned_alloc require size is n times of alignment
+    size = (size + alignment - 1) & ~(alignment - 1);
+    void* ptr = __STL_SYSTEM_ALIGNED_ALLOC(alignment, size);
+    if (ptr == nullptr)
+      ptr = oom_aligned_malloc(size, alignment);
+    __STL_SAMPLE_ALLOCATE(ptr, size);
+    return ptr;
+  }
+
+  /**
+   * @brief deallocate aligned memory
+   * @param[in] ptr memory address
+   * @param[in] size memory size
+   * @param[in] alignment memory align
+   * */
+  static void deallocate(void* ptr, std::size_t /* n*/, std::size_t /* alignment*/) {
+    __STL_SAMPLE_DEALLOCATE(ptr);
+    __STL_SYSTEM_FREE(ptr);
   }
 
   /**
@@ -45,11 +103,13 @@ public:
    * @param[in] size realloc size
    * */
   static void* reallocate(void* ptr, std::size_t /* n*/, std::size_t size) {
-    void* new_ptr = std::realloc(ptr, size);
+    // old block may be reused by other thread once realloc return
+    __STL_SAMPLE_DEALLOCATE(ptr);
+    void* new_ptr = __STL_SYSTEM_REALLOC(ptr, size);
     if (new_ptr == nullptr)
       new_ptr = oom_realloc(ptr, size);
-
-    return ptr;
+    __STL_SAMPLE_ALLOCATE(new_ptr, size);
+    return new_ptr;
   }
   
   /**
@@ -60,24 +120,60 @@ public:
     oom_handler_ = handler;
   }
 
+  /**
+   * @brief add release handler to oom chain
+   *        when malloc fail, handlers are called by priority until malloc succeed,
+   *        the handler set by set_malloc_handler is the last resort
+   * @param[in] handler release handler, must not throw
+   * @param[in] context handler context
+   * @param[in] priority handler priority, smaller run first
+   * @return false if chain is full
+   * */
+  static bool add_release_handler(_malloc_release_handler handler, void* context, int priority) {
+    std::lock_guard<std::mutex> guard(release_mutex_);
+    if (release_count_ == max_release_handler_)
+      return false;
+    // keep chain sorted by priority, same priority run by add order
+    std::size_t index = release_count_;
+    for (; index > 0 && release_chain_[index - 1].priority > priority; index--)
+      release_chain_[index] = release_chain_[index - 1];
+    release_chain_[index] = { handler, context, priority };
+    release_count_++;
+    return true;
+  }
+
+  /**
+   * @brief remove release handler from oom chain
+   * @param[in] handler release handler
+   * @param[in] context handler context
+   * */
+  static void remove_release_handler(_malloc_release_handler handler, void* context) {
+    std::lock_guard<std::mutex> guard(release_mutex_);
+    std::size_t keep = 0;
+    for (std::size_t index = 0; index < release_count_; index++) {
+      if (release_chain_[index].handler == handler && release_chain_[index].context == context)
+        continue;
+      release_chain_[keep++] = release_chain_[index];
+    }
+    release_count_ = keep;
+  }
+
 private:
   /**
    * @brief malloc when out of memory
    * @param[in] size buffer size
    * */
   static void* oom_malloc(std::size_t size) {
-    // check if handler is set
-    // if not, should throw exception
-    if (oom_handler_ == nullptr) 
-      throw std::bad_alloc{};
-    void* ptr = nullptr;
-    do {
-      // try to handler
-      oom_handler_();
-      // remalloc
-      ptr = std::malloc(size);
-    } while (ptr == nullptr);
-    return ptr;
+    return oom_retry([size]() { return __STL_SYSTEM_MALLOC(size); });
+  }
+
+  /**
+   * @brief aligned malloc when out of memory
+   * @param[in] size buffer size
+   * @param[in] alignment buffer align
+   * */
+  static void* oom_aligned_malloc(std::size_t size, std::size_t alignment) {
+    return oom_retry([size, alignment]() { return __STL_SYSTEM_ALIGNED_ALLOC(alignment, size); });
   }
 
   /**
@@ -86,30 +182,165 @@ private:
    * @param[in] size realloc size
    * */
   static void* oom_realloc(void* ptr, std::size_t size) {
-    // check if handler is set
-    // if not, should throw exception
-    if (oom_handler_ == nullptr) 
-      throw std::bad_alloc{};
-    void* new_ptr = nullptr;
-    do {
-      // try to handler
-      oom_handler_();
-      // remalloc
-      new_ptr = std::realloc(ptr, size);
-    } while (new_ptr == nullptr);
-    return new_ptr;
+    return oom_retry([ptr, size]() { return __STL_SYSTEM_REALLOC(ptr, size); });
   }
+
+  /**
+   * @brief release memory by oom chain and retry, until retry succeed
+   *        throw bad_alloc when nothing can be released and no oom handler is set
+   * @param[in] retry retry malloc func
+   * */
+  template<typename Func>
+  static void* oom_retry(Func retry) {
+    for (;;) {
+      // copy chain, handler may free memory back to malloc and add handler
+      release_entry chain[max_release_handler_];
+      std::size_t count = 0;
+      {
+        std::lock_guard<std::mutex> guard(release_mutex_);
+        count = release_count_;
+        for (std::size_t index = 0; index < count; index++)
+          chain[index] = release_chain_[index];
+      }
+      bool released = false;
+      for (std::size_t index = 0; index < count; index++) {
+        if (chain[index].handler(chain[index].context) == 0)
+          continue;
+        // retry once something released, keep cache as much as possible
+        released = true;
+        void* ptr = retry();
+        if (ptr != nullptr)
+          return ptr;
+      }
+      // chain can not release anymore, try oom handler
+      // if not set, should throw exception
+      if (!released) {
+        if (oom_handler_ == nullptr) 
+          throw std::bad_alloc{};
+        oom_handler_();
+        void* ptr = retry();
+        if (ptr != nullptr)
+          return ptr;
+      }
+    }
+  }
+
+private:
+  // release handler entry in oom chain
+  struct release_entry {
+    _malloc_release_handler handler;
+    void* context;
+    int priority;
+  };
+
+  /// max release handler count, fixed so oom path never allocate
+  static const std::size_t max_release_handler_ = 32;
   
 private:
   /// oom handler func
   static _malloc_alloc_handler oom_handler_;
+  /// protect release chain
+  static std::mutex release_mutex_;
+  /// release chain sorted by priority
+  static release_entry release_chain_[max_release_handler_];
+  /// release handler count
+  static std::size_t release_count_;
 };
 
+/// init oom handler
+template<int insl>
+typename _malloc_alloc_template<insl>::_malloc_alloc_handler 
+_malloc_alloc_template<insl>::oom_handler_ = nullptr;
+/// init release mutex
+template<int insl>
+std::mutex _malloc_alloc_template<insl>::release_mutex_;
+/// init release chain
+template<int insl>
+typename _malloc_alloc_template<insl>::release_entry 
+_malloc_alloc_template<insl>::release_chain_[max_release_handler_] = {};
+/// init release handler count
+template<int insl>
+std::size_t _malloc_alloc_template<insl>::release_count_ = 0;
+
 // redefine malloc alloc
 typedef _malloc_alloc_template<0> malloc_alloc;
 
-template<bool thead, int insl> 
+// size class table, map request size to free list index in compile period
+template<std::size_t align, std::size_t max_block>
+struct _alloc_size_class_table {
+  /// index of size, index 0 is never used
+  unsigned short index[max_block + 1];
+
+  /**
+   * @brief generate table in compile period
+   * */
+  constexpr _alloc_size_class_table() : index() {
+    for (std::size_t size = 1; size <= max_block; size++)
+      index[size] = (unsigned short)((size - 1) / align);
+  }
+};
+
+/**
+ * @brief check if value is power of two in compile period
+ * @param[in] value check value
+ * */
+constexpr bool _alloc_is_power_of_two(std::size_t value) {
+  return value != 0 && (value & (value - 1)) == 0;
+}
+
+/**
+ * @brief get log2 of power of two value in compile period
+ * @param[in] value power of two value
+ * */
+constexpr std::size_t _alloc_log2(std::size_t value) {
+  return value <= 1 ? 0 : 1 + _alloc_log2(value >> 1);
+}
+
+// pool lock, no lock for single thread pool
+template<bool thread>
+struct _alloc_lock {
+  void lock() {}
+  void unlock() {}
+  bool try_lock() { return true; }
+};
+
+// thread safe pool lock, recursive because oom chain may trim
+// the pool which is refilling in same thread
+template<>
+struct _alloc_lock<true> {
+  void lock() { mutex.lock(); }
+  void unlock() { mutex.unlock(); }
+  bool try_lock() { return mutex.try_lock(); }
+  /// pool mutex
+  std::recursive_mutex mutex;
+};
+
+// prewarm profile entry, make pool hold count free blocks of size
+struct alloc_prewarm_entry {
+  /// request size
+  std::size_t size;
+  /// free block count
+  std::size_t count;
+};
+
+// align:      free list block align, also the step of size class
+// max_block:  max block size served by free list, larger use malloc directly
+// refill:     block count fetched from chunk once free list is empty
+template<bool thead, int insl, std::size_t align = 8, std::size_t max_block = 128,
+         std::size_t refill_count = 20>
 class _default_alloc_template {
+  static_assert(align >= sizeof(void*), "block must be able to store free list link");
+  static_assert(max_block % align == 0, "max block size must be n times of align");
+  static_assert(refill_count > 0, "refill count must be positive");
+
+public:
+  /// align block size 
+  static constexpr std::size_t align_size = align;
+  /// max block size
+  static constexpr std::size_t max_block_size = max_block;
+  /// block count to refill free list
+  static constexpr std::size_t refill_block_count = refill_count;
+
 public:
   /**
    * @brief allocate memory from alloc 
@@ -119,19 +350,17 @@ public:
     // check if size reach the max size
     // if is, use malloc directly
     if (size > max_block_size_) {
-      return malloc_alloc::allocate(size);
+      void* ptr = malloc_alloc::allocate(size);
+      __STL_TRACE_ALLOCATE(ptr, size);
+      return ptr;
     }
-    // try to get block index
-    int index = get_block_index(size);
-    obj* link_head = *(free_list_[index]);
-    // check if not link exist
-    if (link_head == nullptr) {
-      return refill(bound_up(size));
-    }
-    // get next link, in order to save unused link to free list
-    obj* next_link = link_head->free_list_link;
-    free_list_[index] = next_link;
-    return (void*)*link_head;
+    // zero size take smallest block, so pointer is unique and index is valid
+    if (size == 0)
+      size = 1;
+    // large block is sampled by malloc_alloc, small one out of pool lock
+    void* ptr = allocate_block(size);
+    __STL_SAMPLE_ALLOCATE(ptr, size);
+    return ptr;
   }
   
   /**
@@ -140,18 +369,69 @@ public:
    * @param[in] size memory size
    * */
   static void deallocate(void* ptr, std::size_t size) {
+    __STL_TRACE_DEALLOCATE(ptr, size);
     // check if size is larger than max block size,
     // if is, deallocate directly
     if (size > max_block_size_)
       return malloc_alloc::deallocate(ptr, size);
+    __STL_SAMPLE_DEALLOCATE(ptr);
+    // same block as allocate(0)
+    if (size == 0)
+      size = 1;
+    std::lock_guard<_alloc_lock<thead>> guard(lock_);
     // get block index
     int index = get_block_index(size);
     // get free list
-    obj* link_head = *(free_list_[index]);
+    obj* link_head = free_list_[index];
     ((obj*)ptr)->free_list_link = link_head;
     free_list_[index] = (obj*)ptr;
   }
   
+  /**
+   * @brief allocate aligned memory from alloc
+   *        small over-aligned block is served by pool with that align
+   * @param[in] size alloc size
+   * @param[in] alignment memory align, must be power of two
+   * */
+  static void* allocate(std::size_t size, std::size_t alignment) {
+    // every block is n times of align from aligned chunk
+    if (align_size_ % alignment == 0 && alignment <= chunk_align_)
+      return allocate(size);
+    if (size <= max_block_size_) {
+      switch (alignment) {
+        case 16: return aligned_pool<16>::allocate(size);
+        case 32: return aligned_pool<32>::allocate(size);
+        case 64: return aligned_pool<64>::allocate(size);
+        default: break;
+      }
+    }
+    void* ptr = malloc_alloc::allocate(size, alignment);
+    __STL_TRACE_ALLOCATE(ptr, size);
+    return ptr;
+  }
+
+  /**
+   * @brief deallocate aligned memory to alloc
+   * @param[in] ptr memory address
+   * @param[in] size memory size
+   * @param[in] alignment memory align
+   * */
+  static void deallocate(void* ptr, std::size_t size, std::size_t alignment) {
+    // must keep same route as allocate
+    if (align_size_ % alignment == 0 && alignment <= chunk_align_)
+      return deallocate(ptr, size);
+    if (size <= max_block_size_) {
+      switch (alignment) {
+        case 16: return aligned_pool<16>::deallocate(ptr, size);
+        case 32: return aligned_pool<32>::deallocate(ptr, size);
+        case 64: return aligned_pool<64>::deallocate(ptr, size);
+        default: break;
+      }
+    }
+    __STL_TRACE_DEALLOCATE(ptr, size);
+    malloc_alloc::deallocate(ptr, size, alignment);
+  }
+
   /**
    * @brief get max size
    * */ 
@@ -159,6 +439,185 @@ public:
     return heap_size_;
   }
 
+  /**
+   * @brief make free list of size class hold at least count blocks,
+   *        blocks are linked one by one, so their pages are faulted in here
+   *        instead of on first use
+   * @param[in] size request size of size class
+   * @param[in] count free block count
+   * */
+  static void reserve(std::size_t size, std::size_t count) {
+    // large block use malloc directly, nothing to reserve
+    if (size == 0 || size > max_block_size_)
+      return;
+    std::lock_guard<_alloc_lock<thead>> guard(lock_);
+    std::size_t exist = free_count_aux(bound_up(size), count);
+    if (exist < count)
+      replenish_aux(bound_up(size), count - exist);
+  }
+
+  /**
+   * @brief add count free blocks to size class, no matter how many it holds
+   * @param[in] size request size of size class
+   * @param[in] count block count to add
+   * */
+  static void replenish(std::size_t size, std::size_t count) {
+    if (size == 0 || size > max_block_size_)
+      return;
+    std::lock_guard<_alloc_lock<thead>> guard(lock_);
+    replenish_aux(bound_up(size), count);
+  }
+
+  /**
+   * @brief count free blocks of size class, stop counting at limit
+   * @param[in] size request size of size class
+   * @param[in] limit max count to walk
+   * */
+  static std::size_t free_count(std::size_t size, std::size_t limit) {
+    if (size == 0 || size > max_block_size_)
+      return 0;
+    std::lock_guard<_alloc_lock<thead>> guard(lock_);
+    return free_count_aux(bound_up(size), limit);
+  }
+
+  /**
+   * @brief reserve every size class in profile, e.g. histogram of peak live blocks
+   * @param[in] profile size and count entries
+   * @param[in] count entry count
+   * */
+  static void prewarm(const alloc_prewarm_entry* profile, std::size_t count) {
+    for (std::size_t index = 0; index < count; index++)
+      reserve(profile[index].size, profile[index].count);
+  }
+
+  /**
+   * @brief release chunks whose blocks are all in free list back to malloc
+   *        cost is O(chunk count * free block count), it is for memory pressure,
+   *        thread safe pool registers it to malloc_alloc oom chain once it get first chunk
+   * @return released bytes
+   * */
+  static std::size_t trim() {
+    std::lock_guard<_alloc_lock<thead>> guard(lock_);
+    return trim_aux(nullptr, 0);
+  }
+
+  /**
+   * @brief release idle chunks, but keep at least count free blocks of every size in keep,
+   *        e.g. the reserve a background maintainer hold
+   * @param[in] keep size and count entries
+   * @param[in] count entry count
+   * @return released bytes
+   * */
+  static std::size_t trim(const alloc_prewarm_entry* keep, std::size_t count) {
+    std::lock_guard<_alloc_lock<thead>> guard(lock_);
+    return trim_aux(keep, count);
+  }
+
+  /**
+   * @brief release idle chunks like trim(keep, count), but check at most max_chunks chunks,
+   *        next call continue after them, so periodic trim hold the lock for bounded time
+   * @param[in] keep size and count entries
+   * @param[in] count entry count
+   * @param[in] max_chunks chunks checked by this call
+   * @return released bytes
+   * */
+  static std::size_t trim(const alloc_prewarm_entry* keep, std::size_t count,
+                          std::size_t max_chunks) {
+    std::lock_guard<_alloc_lock<thead>> guard(lock_);
+    return trim_aux(keep, count, max_chunks);
+  }
+
+private:
+  /**
+   * @brief allocate small block from free list
+   * @param[in] size alloc size, not larger than max block size
+   * */
+  static void* allocate_block(std::size_t size) {
+    std::lock_guard<_alloc_lock<thead>> guard(lock_);
+    // try to get block index
+    int index = get_block_index(size);
+    obj* link_head = free_list_[index];
+    // check if not link exist
+    if (link_head == nullptr) {
+      void* ptr = refill(bound_up(size));
+      __STL_TRACE_ALLOCATE(ptr, size);
+      return ptr;
+    }
+    // get next link, in order to save unused link to free list
+    obj* next_link = link_head->free_list_link;
+    free_list_[index] = next_link;
+    __STL_TRACE_ALLOCATE(link_head, size);
+    return (void*)link_head;
+  }
+
+  /**
+   * @brief count free blocks, lock must be held
+   * @param[in] size block size
+   * @param[in] limit max count to walk
+   * */
+  static std::size_t free_count_aux(std::size_t size, std::size_t limit) {
+    std::size_t count = 0;
+    for (obj* block = free_list_[get_block_index(size)]; block != nullptr && count < limit; 
+         block = block->free_list_link)
+      count++;
+    return count;
+  }
+
+  /**
+   * @brief add blocks to free list, lock must be held
+   * @param[in] size block size
+   * @param[in] count block count to add
+   * */
+  static void replenish_aux(std::size_t size, std::size_t count) {
+    while (count > 0) {
+      std::size_t fetch = count;
+      char* result = chunk_alloc(size, fetch);
+      link_blocks(result, size, fetch);
+      count -= fetch;
+    }
+  }
+
+  /**
+   * @brief release idle chunks, lock must be held
+   * @param[in] keep size and count entries to keep, may be nullptr
+   * @param[in] keep_count entry count
+   * @param[in] max_chunks chunks checked, bounded check resume at trim cursor
+   * */
+  static std::size_t trim_aux(const alloc_prewarm_entry* keep, std::size_t keep_count,
+                              std::size_t max_chunks = std::size_t(-1)) {
+    std::size_t released = 0;
+    chunk_header** link = &chunks_;
+    // position of link in chunk list, skip chunks checked by last bounded call
+    std::size_t position = 0;
+    if (max_chunks != std::size_t(-1)) {
+      for (; position < trim_cursor_ && *link != nullptr; position++)
+        link = &(*link)->next;
+    }
+    for (std::size_t checked = 0; *link != nullptr && checked < max_chunks; checked++) {
+      chunk_header* chunk = *link;
+      char* begin = (char*)chunk + chunk_header_size_;
+      char* end = begin + chunk->size;
+      if (idle_bytes(begin, end) != chunk->size || !keeps_reserve(begin, end, keep, keep_count)) {
+        link = &chunk->next;
+        position++;
+        continue;
+      }
+      // whole chunk is idle, drop its blocks from free list
+      unlink_blocks(begin, end);
+      if (start_free_ >= begin && start_free_ <= end) {
+        start_free_ = nullptr;
+        end_free_ = nullptr;
+      }
+      *link = chunk->next;
+      heap_size_ -= chunk->size;
+      released += chunk->size + chunk_header_size_;
+      chunk_deallocate(chunk, chunk->size + chunk_header_size_, over_aligned());
+    }
+    // start over from first chunk once the end is reached
+    trim_cursor_ = *link == nullptr ? 0 : position;
+    return released;
+  }
+
 private:
   /**
    * @brief realloc heap 
@@ -168,7 +627,7 @@ private:
     // bound up size
     size = bound_up(size);
     // stl default use 20 block
-    std::size_t count = 20;
+    std::size_t count = refill_count;
     // try to chunk alloc
     char* result = chunk_alloc(size, count);
     // is is ok return nullptr here
@@ -180,24 +639,37 @@ private:
     // check if only one block is creared
     if (count == 1)
       return result;
+    // first block return to user, left to free list
+    link_blocks(result + size, size, count - 1);
+    return result;
+  }
+
+  /**
+   * @brief link continuous blocks to free list head
+   * @param[in] result first block address
+   * @param[in] size block size
+   * @param[in] count block count
+   * */
+  static void link_blocks(char* result, std::size_t size, std::size_t count) {
     // find next
-    obj* origin, tail;
-    tail = origin = (obj*)(result + size);
+    obj* origin;
+    obj* tail;
+    tail = origin = (obj*)result;
+    tail->free_list_link = nullptr;
     // link all memory
-    for (int index = 2; index < count; index++) {
-      obj* next = (obj*)(index * size);
+    for (std::size_t index = 1; index < count; index++) {
+      obj* next = (obj*)(result + index * size);
       next->free_list_link = nullptr;
       tail->free_list_link = next;
       tail = next;
     }
     // get link head
     int index = get_block_index(size);
-    obj* link_head = *(free_list_[index]);
+    obj* link_head = free_list_[index];
     // link origin head to tail
     tail->free_list_link = link_head;
     // store origin to free list
     free_list_[index] = origin;
-    return result;
   }
   
   /**
@@ -211,13 +683,13 @@ private:
     /// result 
     char* result = nullptr;
     // check if left capibility is enough
-    if (capibility >= total_bytes) {
+    if (capibility >= std::ptrdiff_t(total_bytes)) {
       result = start_free_;
       start_free_ += total_bytes;
       return result; 
     }
     // support at least block
-    if (capibility >= size) {
+    if (capibility >= std::ptrdiff_t(size)) {
       count = capibility / size;
       // calculate available bytes
       std::size_t available_bytes = size * count;
@@ -231,18 +703,19 @@ private:
       // so left capibility is also n times of 8
       // there will no memory leak in this memory pool
       int index = get_block_index(capibility);
-      obj* link_head = *(free_list_[index]);
+      obj* link_head = free_list_[index];
       // store left capibility to free list
-      ((obj*) start_free_)->free_list_link = *link_head;
+      ((obj*) start_free_)->free_list_link = link_head;
       free_list_[index] = (obj*) start_free_;
       // reset start and end free
       start_free_ = nullptr;
       end_free_ = nullptr;
     }
     // new alloc size, 2 total bytes and origin heap size / 16
-    std::size_t alloc_size = 2 * total_bytes + (heap_size_ >> 4);
+    // keep it n times of align size, so left capibility can be put to free list
+    std::size_t alloc_size = 2 * total_bytes + bound_up(heap_size_ >> 4);
     // malloc from address
-    char* alloc_ptr = (char*)malloc_alloc::allocate(alloc_size);
+    char* alloc_ptr = new_chunk(alloc_size);
     // check if malloc successfully
     // if malloc successfully, add new memory to free list
     if (alloc_ptr != nullptr) { 
@@ -260,24 +733,173 @@ private:
     // obviously, traditional stl cant deal with this situation
     int index = get_block_index(size);
     for (; index < get_block_count(); index++) {
-      obj* link_head = *(free_list_[index]);
+      obj* link_head = free_list_[index];
       // check if exist at least one free block
       if (link_head == nullptr)
         continue;
+      // take block from free list, use it as free memory
+      free_list_[index] = link_head->free_list_link;
       // get start and end free
-      start_free_ = *link_head;
+      start_free_ = (char*)link_head;
       end_free_ = start_free_ + (index + 1) * align_size_;
       return chunk_alloc(size, count);
     }
-    return nullptr;
+    throw std::bad_alloc{};
+  }
+
+  /**
+   * @brief get new chunk from malloc, chunk is recorded so it can be trimmed
+   * @param[in] size chunk size
+   * @return chunk memory, nullptr if malloc failed
+   * */
+  static char* new_chunk(std::size_t size) {
+    char* ptr = nullptr;
+    try {
+      // chunk is pool memory, not allocation of caller
+      __STL_SAMPLE_SUSPEND();
+      ptr = (char*)chunk_allocate(size + chunk_header_size_, over_aligned());
+    } catch (const std::bad_alloc&) {
+      return nullptr;
+    }
+    chunk_header* chunk = (chunk_header*)ptr;
+    chunk->next = chunks_;
+    chunk->size = size;
+    chunks_ = chunk;
+    // let oom chain trim this pool, oom may happen on any thread, so a single thread
+    // pool is never registered, its owner call trim() itself
+    if (thead && !release_registered_) {
+      release_registered_ = malloc_alloc::add_release_handler(
+          release_handler, nullptr, malloc_alloc::pool_release_priority);
+    }
+    return ptr + chunk_header_size_;
+  }
+
+  /**
+   * @brief release handler in malloc_alloc oom chain
+   * */
+  static std::size_t release_handler(void* /* context*/) {
+    // other thread may hold this pool and wait for the pool we are refilling
+    if (!lock_.try_lock())
+      return 0;
+    std::size_t released = trim_aux(nullptr, 0);
+    lock_.unlock();
+    return released;
+  }
+
+  /**
+   * @brief count free bytes located in [begin, end)
+   * @param[in] begin chunk begin
+   * @param[in] end chunk end
+   * */
+  static std::size_t idle_bytes(char* begin, char* end) {
+    std::size_t bytes = 0;
+    if (start_free_ >= begin && start_free_ < end)
+      bytes += end_free_ - start_free_;
+    for (int index = 0; index < get_block_count(); index++) {
+      for (obj* block = free_list_[index]; block != nullptr; block = block->free_list_link) {
+        if ((char*)block >= begin && (char*)block < end)
+          bytes += (index + 1) * align_size_;
+      }
+    }
+    return bytes;
+  }
+
+  /**
+   * @brief check if free blocks out of [begin, end) still hold every kept count
+   * @param[in] begin chunk begin
+   * @param[in] end chunk end
+   * @param[in] keep size and count entries, may be nullptr
+   * @param[in] count entry count
+   * */
+  static bool keeps_reserve(char* begin, char* end, const alloc_prewarm_entry* keep,
+                            std::size_t count) {
+    for (std::size_t index = 0; index < count; index++) {
+      if (keep[index].size == 0 || keep[index].size > max_block_size_)
+        continue;
+      // walk stop once enough blocks are found outside
+      std::size_t outside = 0;
+      for (obj* block = free_list_[get_block_index(keep[index].size)];
+           block != nullptr && outside < keep[index].count; block = block->free_list_link) {
+        if ((char*)block < begin || (char*)block >= end)
+          outside++;
+      }
+      if (outside < keep[index].count)
+        return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief remove free blocks located in [begin, end) from free list
+   * @param[in] begin chunk begin
+   * @param[in] end chunk end
+   * */
+  static void unlink_blocks(char* begin, char* end) {
+    for (int index = 0; index < get_block_count(); index++) {
+      obj** link = &free_list_[index];
+      while (*link != nullptr) {
+        if ((char*)*link >= begin && (char*)*link < end)
+          *link = (*link)->free_list_link;
+        else
+          link = &(*link)->free_list_link;
+      }
+    }
+  }
+
+  /**
+   * @brief allocate chunk, malloc align is enough
+   * @param[in] size chunk size
+   * */
+  static void* chunk_allocate(std::size_t size, std::false_type) {
+    return malloc_alloc::allocate(size);
+  }
+
+  /**
+   * @brief allocate chunk aligned to block align
+   * @param[in] size chunk size
+   * */
+  static void* chunk_allocate(std::size_t size, std::true_type) {
+    return malloc_alloc::allocate(size, align);
+  }
+
+  /**
+   * @brief release chunk
+   * @param[in] ptr chunk address
+   * @param[in] size chunk size
+   * */
+  static void chunk_deallocate(void* ptr, std::size_t size, std::false_type) {
+    malloc_alloc::deallocate(ptr, size);
+  }
+
+  /**
+   * @brief release aligned chunk
+   * @param[in] ptr chunk address
+   * @param[in] size chunk size
+   * */
+  static void chunk_deallocate(void* ptr, std::size_t size, std::true_type) {
+    malloc_alloc::deallocate(ptr, size, align);
   }
 
 private:
+  /// pool serve over-aligned block, share geometry except align
+  template<std::size_t alignment>
+  using aligned_pool = _default_alloc_template<thead, insl, alignment,
+                                               (max_block + alignment - 1) / alignment * alignment,
+                                               refill_count>;
+  /// power of two align larger than malloc align, chunk must be aligned
+  typedef std::integral_constant<bool, _alloc_is_power_of_two(align) && 
+                                 (align > malloc_alloc::align_size)> over_aligned;
+
   // obj to store heap block
   union  obj {
     obj* free_list_link;
     char* client_data;
   };
+  // header in front of every chunk, link all chunks
+  struct chunk_header {
+    chunk_header* next;
+    std::size_t size;
+  };
   /**
    * @brief get block count in compile peroid
    * */ 
@@ -287,28 +909,68 @@ private:
   
   /**
    * @brief calculate located block index
-   * @param[in] size block size
+   * @param[in] size block size, must in (0, max_block_size_]
    * */  
   static int get_block_index(std::size_t size) {
-    // TODO: may not correct here
-    return (size - 1) / align_size_;
+    typedef std::integral_constant<bool, _alloc_is_power_of_two(align)> power_of_two;
+    return get_block_index_aux(size, power_of_two());
+  }
+
+  /**
+   * @brief power of two align, use shift
+   * @param[in] size block size
+   * */
+  static int get_block_index_aux(std::size_t size, std::true_type) {
+    return int((size - 1) >> _alloc_log2(align));
+  }
+
+  /**
+   * @brief other align, use size class table
+   * @param[in] size block size
+   * */
+  static int get_block_index_aux(std::size_t size, std::false_type) {
+    return size_class_table_.index[size];
   }
 
   /**
    * @brief bound up
    * @param[in] size bound size
    * */
-  static int bound_up(std::size_t size) {
-    return (size + align_size_ - 1) / align_size_ * align_size_;
+  static std::size_t bound_up(std::size_t size) {
+    typedef std::integral_constant<bool, _alloc_is_power_of_two(align)> power_of_two;
+    return bound_up_aux(size, power_of_two());
+  }
+
+  /**
+   * @brief power of two align, use mask
+   * @param[in] size bound size
+   * */
+  static std::size_t bound_up_aux(std::size_t size, std::true_type) {
+    return (size + align - 1) & ~(align - 1);
+  }
+
+  /**
+   * @brief other align, use division
+   * @param[in] size bound size
+   * */
+  static std::size_t bound_up_aux(std::size_t size, std::false_type) {
+    return (size + align - 1) / align * align;
   }
 
 private:
   /// align block size 
-  static const std::size_t align_size_ = 8;
+  static constexpr std::size_t align_size_ = align;
   /// max block size
-  static const std::size_t max_block_size_ = 128;
+  static constexpr std::size_t max_block_size_ = max_block;
+  /// chunk address align
+  static constexpr std::size_t chunk_align_ = over_aligned::value ? align : malloc_alloc::align_size;
+  /// chunk header size, keep blocks aligned
+  static constexpr std::size_t chunk_header_size_ = (sizeof(chunk_header) + align - 1) / align * align;
+  /// size class table, only used when align is not power of two
+  static constexpr _alloc_size_class_table<align, max_block> size_class_table_ {};
+  /// protect free list and chunk
+  static _alloc_lock<thead> lock_;
   /// free list to store first block of obj 
-  /// TODO: should use violate here
   static obj* free_list_[get_block_count()];
   /// free memory start address
   static char* start_free_;
@@ -316,20 +978,45 @@ private:
   static char* end_free_;
   /// heap size
   static std::size_t heap_size_;
+  /// all chunks get from malloc
+  static chunk_header* chunks_;
+  /// check if trim is added to oom chain
+  static bool release_registered_;
+  /// chunk position where next bounded trim start
+  static std::size_t trim_cursor_;
 };
 
 /// init start free static address
-template<bool thread, int insl>
-char* _default_alloc_template<thread, insl>::start_free_ = nullptr;
+template<bool thread, int insl, std::size_t align, std::size_t max_block, std::size_t refill>
+char* _default_alloc_template<thread, insl, align, max_block, refill>::start_free_ = nullptr;
 /// init end free static address
-template<bool thread, int insl>
-char* _default_alloc_template<thread, insl>::end_free_ = nullptr;
+template<bool thread, int insl, std::size_t align, std::size_t max_block, std::size_t refill>
+char* _default_alloc_template<thread, insl, align, max_block, refill>::end_free_ = nullptr;
 /// init head size
-template<bool thread, int insl>
-std::size_t _default_alloc_template<thread, insl>::heap_size_ = 0;
+template<bool thread, int insl, std::size_t align, std::size_t max_block, std::size_t refill>
+std::size_t _default_alloc_template<thread, insl, align, max_block, refill>::heap_size_ = 0;
+/// init pool lock
+template<bool thread, int insl, std::size_t align, std::size_t max_block, std::size_t refill>
+_alloc_lock<thread> _default_alloc_template<thread, insl, align, max_block, refill>::lock_;
+/// init chunk list
+template<bool thread, int insl, std::size_t align, std::size_t max_block, std::size_t refill>
+typename _default_alloc_template<thread, insl, align, max_block, refill>::chunk_header* 
+_default_alloc_template<thread, insl, align, max_block, refill>::chunks_ = nullptr;
+/// init release registered flag
+template<bool thread, int insl, std::size_t align, std::size_t max_block, std::size_t refill>
+bool _default_alloc_template<thread, insl, align, max_block, refill>::release_registered_ = false;
+/// init trim cursor
+template<bool thread, int insl, std::size_t align, std::size_t max_block, std::size_t refill>
+std::size_t _default_alloc_template<thread, insl, align, max_block, refill>::trim_cursor_ = 0;
 /// init free list 
-template<bool thread, int insl>
-typename _default_alloc_template<thread, insl>::obj* _default_alloc_template<thread, insl>::free_list_[get_block_count()] = {};
+template<bool thread, int insl, std::size_t align, std::size_t max_block, std::size_t refill>
+typename _default_alloc_template<thread, insl, align, max_block, refill>::obj* 
+_default_alloc_template<thread, insl, align, max_block, refill>::free_list_[get_block_count()] = {};
+
+/// default pool used by containers
+typedef _default_alloc_template<true, 0> alloc;
+/// pool with 16 bytes align, up to 512 bytes block
+typedef _default_alloc_template<true, 0, 16, 512> alloc_16_512;
 
 // simple_alloc use to pack alloc 
 template<typename T, typename Alloc> 
@@ -357,7 +1044,7 @@ public:
   /**
    * @brief destroy obj
    * */
-  virtual~simple_alloc() {}
+  ~simple_alloc() {}
 
   /**
    * @brief get address from reference
@@ -380,15 +1067,15 @@ public:
    * @param[in] size alloc size
    * @param[in] void* non used
    * */
-  pointer allocate(size_type size) {
-    return (pointer)Alloc::allocate(size * sizeof(T));
+  static pointer allocate(size_type size) {
+    return (pointer)allocate_aux(size * sizeof(T), over_aligned());
   }
   
   /**
    * @brief allocate memory from Alloc
    * */
-  pointer allocate(void) {
-    return (pointer)Alloc::allocate(sizeof(T));
+  static pointer allocate(void) {
+    return (pointer)allocate_aux(sizeof(T), over_aligned());
   }
   
   /**
@@ -396,8 +1083,8 @@ public:
    * @param[in] ptr obj address
    * @param[in] size obj size
    * */
-  void deallocate(pointer ptr, size_type size) {
-    return (pointer)Alloc::deallocate(ptr, size);
+  static void deallocate(pointer ptr, size_type size) {
+    deallocate_aux(ptr, size * sizeof(T), over_aligned());
   }
   
   /**
@@ -423,6 +1110,297 @@ public:
   void destroy(pointer ptr) {
     return stl::destroy(ptr);
   }
+
+private:
+  /// T require larger align than Alloc guarantee
+  typedef std::integral_constant<bool, (alignof(T) > Alloc::align_size)> over_aligned;
+
+  /**
+   * @brief Alloc align is enough
+   * @param[in] bytes alloc bytes
+   * */
+  static void* allocate_aux(size_type bytes, std::false_type) {
+    return Alloc::allocate(bytes);
+  }
+
+  /**
+   * @brief T is over-aligned, use aligned allocate
+   * @param[in] bytes alloc bytes
+   * */
+  static void* allocate_aux(size_type bytes, std::true_type) {
+    return Alloc::allocate(bytes, alignof(T));
+  }
+
+  /**
+   * @brief Alloc align is enough
+   * @param[in] ptr obj address
+   * @param[in] bytes alloc bytes
+   * */
+  static void deallocate_aux(pointer ptr, size_type bytes, std::false_type) {
+    Alloc::deallocate(ptr, bytes);
+  }
+
+  /**
+   * @brief T is over-aligned, use aligned deallocate
+   * @param[in] ptr obj address
+   * @param[in] bytes alloc bytes
+   * */
+  static void deallocate_aux(pointer ptr, size_type bytes, std::true_type) {
+    Alloc::deallocate(ptr, bytes, alignof(T));
+  }
+};
+
+// pool_allocator, stateless standard allocator over Alloc,
+// let std::map, std::list and std::unordered_map nodes come from pool
+template<typename T, typename Alloc = alloc>
+class pool_allocator {
+public:
+  // std allocator definition
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef std::true_type is_always_equal;
+  typedef std::true_type propagate_on_container_move_assignment;
+
+  template<typename U>
+  struct rebind {
+    typedef pool_allocator<U, Alloc> other;
+  };
+
+public:
+  /**
+   * @brief construct
+   * */
+  pool_allocator() noexcept {}
+
+  /**
+   * @brief rebind construct
+   * */
+  template<typename U>
+  pool_allocator(const pool_allocator<U, Alloc>&) noexcept {}
+
+  /**
+   * @brief allocate count obj
+   * @param[in] count obj count
+   * */
+  T* allocate(size_type count) {
+    return simple_alloc<T, Alloc>::allocate(count);
+  }
+
+  /**
+   * @brief deallocate count obj
+   * @param[in] ptr obj address
+   * @param[in] count obj count
+   * */
+  void deallocate(T* ptr, size_type count) noexcept {
+    simple_alloc<T, Alloc>::deallocate(ptr, count);
+  }
+};
+
+/**
+ * @brief pool allocators are stateless, always equal
+ * */
+template<typename T, typename U, typename Alloc>
+inline bool operator==(const pool_allocator<T, Alloc>&, const pool_allocator<U, Alloc>&) {
+  return true;
+}
+
+/**
+ * @brief pool allocators are stateless, always equal
+ * */
+template<typename T, typename U, typename Alloc>
+inline bool operator!=(const pool_allocator<T, Alloc>&, const pool_allocator<U, Alloc>&) {
+  return false;
+}
+
+// aligned_alloc_adapter make every block of Alloc aligned to Align,
+// use it as container alloc to get cache line or simd aligned buffer
+template<typename Alloc, std::size_t Align>
+class aligned_alloc_adapter {
+  static_assert(_alloc_is_power_of_two(Align), "align must be power of two");
+
+public:
+  /// every block align
+  static constexpr std::size_t align_size = Align > Alloc::align_size ? Align : Alloc::align_size;
+
+public:
+  /**
+   * @brief allocate aligned memory
+   * @param[in] size alloc size
+   * */
+  static void* allocate(std::size_t size) {
+    return Alloc::allocate(size, align_size);
+  }
+
+  /**
+   * @brief deallocate aligned memory
+   * @param[in] ptr memory address
+   * @param[in] size memory size
+   * */
+  static void deallocate(void* ptr, std::size_t size) {
+    Alloc::deallocate(ptr, size, align_size);
+  }
+
+  /**
+   * @brief allocate memory with larger align
+   * @param[in] size alloc size
+   * @param[in] alignment memory align
+   * */
+  static void* allocate(std::size_t size, std::size_t alignment) {
+    return Alloc::allocate(size, alignment > align_size ? alignment : align_size);
+  }
+
+  /**
+   * @brief deallocate memory with larger align
+   * @param[in] ptr memory address
+   * @param[in] size memory size
+   * @param[in] alignment memory align
+   * */
+  static void deallocate(void* ptr, std::size_t size, std::size_t alignment) {
+    Alloc::deallocate(ptr, size, alignment > align_size ? alignment : align_size);
+  }
+
+  /**
+   * @brief get max size
+   * */
+  static std::size_t max_size() {
+    return Alloc::max_size();
+  }
+};
+
+// size_header_alloc put a header in front of every block, so block can be
+// deallocated by address only, e.g. to serve free() on top of pool
+// header take align bytes at least, use pool with 16 bytes align for malloc semantic
+template<typename Alloc = alloc_16_512>
+class size_header_alloc {
+public:
+  /// every block align
+  static constexpr std::size_t align_size = Alloc::align_size;
+
+public:
+  /**
+   * @brief allocate memory
+   * @param[in] size alloc size
+   * */
+  static void* allocate(std::size_t size) {
+    // header is added below, wrapped total would be a small block
+    if (size > std::size_t(-1) - header_size_)
+      throw std::bad_alloc{};
+    std::size_t total = size + header_size_;
+    char* base = (char*)Alloc::allocate(total);
+    header* head = (header*)base;
+    head->size = total;
+    head->alignment = 0;
+    return base + header_size_;
+  }
+
+  /**
+   * @brief allocate aligned memory
+   * @param[in] size alloc size
+   * @param[in] alignment memory align, must be power of two
+   * */
+  static void* allocate(std::size_t size, std::size_t alignment) {
+    if (alignment <= align_size)
+      return allocate(size);
+    std::size_t offset = aligned_offset(alignment);
+    if (size > std::size_t(-1) - offset)
+      throw std::bad_alloc{};
+    std::size_t total = size + offset;
+    char* ptr = (char*)Alloc::allocate(total, alignment) + offset;
+    header* head = (header*)(ptr - header_size_);
+    head->size = total;
+    head->alignment = alignment;
+    return ptr;
+  }
+
+  /**
+   * @brief deallocate memory by address only
+   * @param[in] ptr memory address
+   * */
+  static void deallocate(void* ptr) {
+    header* head = (header*)((char*)ptr - header_size_);
+    if (head->alignment == 0)
+      return Alloc::deallocate(head, head->size);
+    std::size_t alignment = head->alignment;
+    Alloc::deallocate((char*)ptr - aligned_offset(alignment), head->size, alignment);
+  }
+
+  /**
+   * @brief deallocate memory, size is ignored
+   * @param[in] ptr memory address
+   * @param[in] size memory size
+   * */
+  static void deallocate(void* ptr, std::size_t /* size*/) {
+    deallocate(ptr);
+  }
+
+  /**
+   * @brief deallocate aligned memory, size and align are ignored
+   * @param[in] ptr memory address
+   * @param[in] size memory size
+   * @param[in] alignment memory align
+   * */
+  static void deallocate(void* ptr, std::size_t /* size*/, std::size_t /* alignment*/) {
+    deallocate(ptr);
+  }
+
+  /**
+   * @brief get usable size of block
+   * @param[in] ptr memory address
+   * */
+  static std::size_t usable_size(const void* ptr) {
+    const header* head = (const header*)((const char*)ptr - header_size_);
+    std::size_t offset = head->alignment == 0 ? header_size_ : aligned_offset(head->alignment);
+    return head->size - offset;
+  }
+
+  /**
+   * @brief resize block, keep it when new size still fit and not waste half
+   * @param[in] ptr memory address, may be nullptr
+   * @param[in] size new size
+   * */
+  static void* reallocate(void* ptr, std::size_t size) {
+    if (ptr == nullptr)
+      return allocate(size);
+    std::size_t usable = usable_size(ptr);
+    if (size <= usable && size >= usable / 2)
+      return ptr;
+    std::size_t alignment = ((header*)((char*)ptr - header_size_))->alignment;
+    void* new_ptr = alignment == 0 ? allocate(size) : allocate(size, alignment);
+    std::memcpy(new_ptr, ptr, size < usable ? size : usable);
+    deallocate(ptr);
+    return new_ptr;
+  }
+
+  /**
+   * @brief get max size
+   * */
+  static std::size_t max_size() {
+    return Alloc::max_size();
+  }
+
+private:
+  // header in front of every block
+  struct header {
+    /// size passed to Alloc
+    std::size_t size;
+    /// align passed to Alloc, zero if not aligned
+    std::size_t alignment;
+  };
+
+  /**
+   * @brief distance from aligned block begin to user memory
+   * @param[in] alignment memory align
+   * */
+  static std::size_t aligned_offset(std::size_t alignment) {
+    return (header_size_ + alignment - 1) & ~(alignment - 1);
+  }
+
+private:
+  /// header size, keep user memory aligned
+  static constexpr std::size_t header_size_ = (sizeof(header) + align_size - 1) / align_size * align_size;
 };
 
 }
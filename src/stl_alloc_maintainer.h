@@ -0,0 +1,160 @@
+#ifndef __STL_ALLOC_MAINTAINER_H__
+#define __STL_ALLOC_MAINTAINER_H__
+
+#include "stl_alloc.h"
+
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <condition_variable>
+
+namespace stl {
+
+// watermark of one size class, when free blocks drop below low,
+// maintainer replenish it to high
+struct alloc_watermark {
+  /// request size of size class
+  std::size_t size;
+  /// low water mark
+  std::size_t low;
+  /// high water mark
+  std::size_t high;
+};
+
+// alloc_maintainer, background thread keep pool free lists above low water mark,
+// so callers rarely pay refill and chunk_alloc inline
+// Alloc must be a thread safe pool, e.g. alloc
+template<typename Alloc = alloc>
+class alloc_maintainer {
+public:
+  /**
+   * @brief construct, thread is not started
+   * @param[in] marks watermarks of size classes
+   * @param[in] count watermark count
+   * @param[in] interval check interval
+   * @param[in] trim_interval trim idle chunks interval, zero disable trim,
+   *            trim keep high free blocks of every size class
+   * @param[in] trim_chunks chunks checked by one trim tick, every check walk all free
+   *            blocks under the pool lock, so a tick stall callers for bounded time
+   * */
+  alloc_maintainer(const alloc_watermark* marks, std::size_t count,
+                   std::chrono::milliseconds interval = std::chrono::milliseconds(1),
+                   std::chrono::milliseconds trim_interval = std::chrono::milliseconds(0),
+                   std::size_t trim_chunks = 16)
+      : marks_(marks, marks + count), interval_(interval), trim_interval_(trim_interval),
+        trim_chunks_(trim_chunks) {
+    for (const alloc_watermark& mark : marks_)
+      reserves_.push_back(alloc_prewarm_entry { mark.size, mark.high });
+  }
+
+  alloc_maintainer(const alloc_maintainer&) = delete;
+  alloc_maintainer& operator=(const alloc_maintainer&) = delete;
+
+  /**
+   * @brief stop thread
+   * */
+  ~alloc_maintainer() {
+    stop();
+  }
+
+public:
+  /**
+   * @brief start background thread, replenish once before return
+   * */
+  void start() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (thread_.joinable())
+      return;
+    stopping_ = false;
+    maintain();
+    thread_ = std::thread(&alloc_maintainer::run, this);
+  }
+
+  /**
+   * @brief stop background thread and wait it exit
+   * */
+  void stop() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (!thread_.joinable())
+        return;
+      stopping_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+  }
+
+  /**
+   * @brief wake thread to check watermarks now, e.g. before burst
+   * */
+  void wakeup() {
+    cond_.notify_all();
+  }
+
+private:
+  /**
+   * @brief thread loop
+   * */
+  void run() {
+    typedef std::chrono::steady_clock clock;
+    clock::time_point last_trim = clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+      cond_.wait_for(lock, interval_);
+      if (stopping_)
+        break;
+      lock.unlock();
+      maintain();
+      if (trim_interval_.count() > 0 && clock::now() - last_trim >= trim_interval_) {
+        // only chunks beyond the reserve are released, or next tick refill them again,
+        // later ticks continue with the following chunks
+        Alloc::trim(reserves_.data(), reserves_.size(), trim_chunks_);
+        last_trim = clock::now();
+      }
+      lock.lock();
+    }
+  }
+
+  /**
+   * @brief replenish size classes below low water mark,
+   *        add refill_block_count blocks each time to keep pool lock short
+   * */
+  void maintain() {
+    for (const alloc_watermark& mark : marks_) {
+      std::size_t count = Alloc::free_count(mark.size, mark.low);
+      if (count >= mark.low || count >= mark.high)
+        continue;
+      for (std::size_t need = mark.high - count; need > 0;) {
+        std::size_t step = need < Alloc::refill_block_count ? need : Alloc::refill_block_count;
+        Alloc::replenish(mark.size, step);
+        need -= step;
+      }
+    }
+  }
+
+private:
+  /// watermarks
+  std::vector<alloc_watermark> marks_;
+  /// free blocks kept by trim, high water mark of every size class
+  std::vector<alloc_prewarm_entry> reserves_;
+  /// check interval
+  std::chrono::milliseconds interval_;
+  /// trim interval
+  std::chrono::milliseconds trim_interval_;
+  /// chunks checked by one trim tick
+  std::size_t trim_chunks_;
+  /// protect stopping flag
+  std::mutex mutex_;
+  /// wait interval or stop
+  std::condition_variable cond_;
+  /// stopping flag
+  bool stopping_ { false };
+  /// background thread
+  std::thread thread_;
+};
+
+}
+
+#endif // !__STL_ALLOC_MAINTAINER_H__
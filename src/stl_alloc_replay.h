@@ -0,0 +1,308 @@
+#ifndef __STL_ALLOC_REPLAY_H__
+#define __STL_ALLOC_REPLAY_H__
+
+#include "stl_alloc.h"
+#include "stl_alloc_trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+
+// glibc 2.33 and later report malloc heap use by mallinfo2
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define __STL_REPLAY_MALLINFO2 1
+#endif
+
+namespace stl {
+
+// replay result of one allocator
+struct alloc_replay_report {
+  /// replayed allocate and deallocate count
+  std::size_t operations { 0 };
+  /// time spent in allocator
+  double seconds { 0 };
+  /// peak bytes requested and not released
+  std::size_t peak_live_bytes { 0 };
+  /// peak bytes hold by allocator
+  std::size_t peak_heap_bytes { 0 };
+  /// heap bytes can be measured, otherwise peak_heap_bytes and fragmentation are unknown
+  bool heap_measured { true };
+  /// 1 - peak_live_bytes / peak_heap_bytes
+  double fragmentation { 0 };
+};
+
+// replay operation, address is resolved to slot
+struct alloc_replay_op {
+  /// slot index of block
+  std::size_t slot;
+  /// request size
+  std::size_t size;
+  /// alloc_trace_op
+  std::uint8_t op;
+};
+
+// general allocator heap trait, allocator is malloc based,
+// heap is bytes malloc hand out, headers and mmap'd blocks included
+template<typename Alloc>
+struct alloc_replay_trait {
+  /**
+   * @brief check if heap size can be measured
+   * */
+  static bool measured() {
+#ifdef __STL_REPLAY_MALLINFO2
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * @brief take heap in use before replay, it is not counted
+   * */
+  static void start() {
+    base_bytes() = malloc_bytes();
+  }
+
+  /**
+   * @brief get bytes hold by allocator since start
+   * @param[in] live_bytes live bytes requested
+   * @param[in] large_bytes live bytes above pool limit
+   * */
+  static std::size_t heap_size(std::size_t /* live_bytes*/, std::size_t /* large_bytes*/) {
+    std::size_t bytes = malloc_bytes();
+    return bytes > base_bytes() ? bytes - base_bytes() : 0;
+  }
+
+  /**
+   * @brief check if size is served by pool
+   * @param[in] size request size
+   * */
+  static bool pooled(std::size_t /* size*/) {
+    return false;
+  }
+
+private:
+  /**
+   * @brief bytes in use by malloc, 0 if unknown
+   * */
+  static std::size_t malloc_bytes() {
+#ifdef __STL_REPLAY_MALLINFO2
+    struct mallinfo2 info = ::mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+  }
+
+  /**
+   * @brief heap in use before replay
+   * */
+  static std::size_t& base_bytes() {
+    static std::size_t bytes = 0;
+    return bytes;
+  }
+};
+
+// pool heap trait, pool heap never shrink
+template<bool thread, int insl, std::size_t align, std::size_t max_block, std::size_t refill>
+struct alloc_replay_trait<_default_alloc_template<thread, insl, align, max_block, refill>> {
+  typedef _default_alloc_template<thread, insl, align, max_block, refill> pool;
+
+  /**
+   * @brief check if heap size can be measured
+   * */
+  static bool measured() {
+    return true;
+  }
+
+  /**
+   * @brief nothing to take, warm pool heap is counted
+   * */
+  static void start() {}
+
+  /**
+   * @brief get bytes hold by pool
+   * @param[in] live_bytes live bytes requested
+   * @param[in] large_bytes live bytes above pool limit
+   * */
+  static std::size_t heap_size(std::size_t /* live_bytes*/, std::size_t large_bytes) {
+    return pool::max_size() + large_bytes;
+  }
+
+  /**
+   * @brief check if size is served by pool
+   * @param[in] size request size
+   * */
+  static bool pooled(std::size_t size) {
+    return size <= pool::max_block_size;
+  }
+};
+
+/**
+ * @brief load trace file recorded by alloc_trace
+ * @param[in] path trace file path
+ * @param[out] records trace records
+ * */
+inline bool load_alloc_trace(const char* path, std::vector<alloc_trace_record>& records) {
+  std::FILE* file = std::fopen(path, "rb");
+  if (file == nullptr)
+    return false;
+  // check header
+  alloc_trace_header header;
+  if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+      std::memcmp(header.magic, alloc_trace_magic, sizeof(header.magic)) != 0 ||
+      header.version != alloc_trace_version ||
+      header.record_size != sizeof(alloc_trace_record)) {
+    std::fclose(file);
+    return false;
+  }
+  // read all records
+  alloc_trace_record rec;
+  while (std::fread(&rec, sizeof(rec), 1, file) == 1)
+    records.push_back(rec);
+  std::fclose(file);
+  return true;
+}
+
+/**
+ * @brief resolve record address to slot, so replay no need to lookup address
+ * @param[in] records trace records
+ * @param[out] ops replay operations
+ * @return slot count
+ * */
+inline std::size_t compile_alloc_trace(const std::vector<alloc_trace_record>& records,
+                                       std::vector<alloc_replay_op>& ops) {
+  std::unordered_map<std::uint64_t, std::size_t> live;
+  std::size_t slot_count = 0;
+  ops.reserve(records.size());
+  for (const alloc_trace_record& rec : records) {
+    if (rec.op == trace_allocate) {
+      live[rec.address] = slot_count;
+      ops.push_back({ slot_count++, rec.size, trace_allocate });
+      continue;
+    }
+    // deallocate block allocated before recording, ignore it
+    auto iter = live.find(rec.address);
+    if (iter == live.end())
+      continue;
+    ops.push_back({ iter->second, rec.size, trace_deallocate });
+    live.erase(iter);
+  }
+  return slot_count;
+}
+
+template<typename Alloc>
+/**
+ * @brief replay operations against allocator
+ *        pool state is static, replay same allocator twice will run on warm pool
+ * @param[in] ops replay operations
+ * @param[in] slot_count slot count
+ * */
+alloc_replay_report replay_alloc_trace(const std::vector<alloc_replay_op>& ops,
+                                       std::size_t slot_count) {
+  typedef alloc_replay_trait<Alloc> trait;
+  typedef std::chrono::steady_clock clock;
+  alloc_replay_report report;
+  std::vector<void*> slots(slot_count, nullptr);
+  std::vector<std::size_t> sizes(slot_count, 0);
+  std::size_t live_bytes = 0;
+  std::size_t large_bytes = 0;
+  report.heap_measured = trait::measured();
+  trait::start();
+  clock::duration spent = clock::duration::zero();
+  for (const alloc_replay_op& op : ops) {
+    clock::time_point begin = clock::now();
+    if (op.op == trace_allocate) {
+      slots[op.slot] = Alloc::allocate(op.size);
+    } else {
+      Alloc::deallocate(slots[op.slot], op.size);
+      slots[op.slot] = nullptr;
+    }
+    spent += clock::now() - begin;
+    // update statistic out of timing
+    if (op.op == trace_allocate) {
+      sizes[op.slot] = op.size;
+      live_bytes += op.size;
+      if (!trait::pooled(op.size))
+        large_bytes += op.size;
+    } else {
+      live_bytes -= op.size;
+      if (!trait::pooled(op.size))
+        large_bytes -= op.size;
+    }
+    std::size_t heap_bytes = trait::heap_size(live_bytes, large_bytes);
+    if (live_bytes > report.peak_live_bytes)
+      report.peak_live_bytes = live_bytes;
+    if (heap_bytes > report.peak_heap_bytes)
+      report.peak_heap_bytes = heap_bytes;
+  }
+  report.operations = ops.size();
+  report.seconds = std::chrono::duration<double>(spent).count();
+  if (report.peak_heap_bytes > 0)
+    report.fragmentation = 1.0 - double(report.peak_live_bytes) / report.peak_heap_bytes;
+  // release blocks never deallocated in trace
+  for (std::size_t index = 0; index < slot_count; index++) {
+    if (slots[index] != nullptr)
+      Alloc::deallocate(slots[index], sizes[index]);
+  }
+  return report;
+}
+
+template<typename Alloc>
+/**
+ * @brief build prewarm profile from trace, peak live block count of every pool size class
+ * @param[in] records trace records
+ * @param[out] profile prewarm profile for Alloc::prewarm
+ * */
+void build_prewarm_profile(const std::vector<alloc_trace_record>& records,
+                           std::vector<alloc_prewarm_entry>& profile) {
+  const std::size_t class_count = Alloc::max_block_size / Alloc::align_size;
+  std::vector<std::size_t> live(class_count, 0);
+  std::vector<std::size_t> peak(class_count, 0);
+  std::unordered_map<std::uint64_t, std::size_t> sizes;
+  for (const alloc_trace_record& rec : records) {
+    if (rec.size == 0 || rec.size > Alloc::max_block_size)
+      continue;
+    std::size_t index = (rec.size - 1) / Alloc::align_size;
+    if (rec.op == trace_allocate) {
+      sizes[rec.address] = index;
+      if (++live[index] > peak[index])
+        peak[index] = live[index];
+      continue;
+    }
+    // deallocate block allocated before recording, ignore it
+    auto iter = sizes.find(rec.address);
+    if (iter == sizes.end())
+      continue;
+    live[iter->second]--;
+    sizes.erase(iter);
+  }
+  for (std::size_t index = 0; index < class_count; index++) {
+    if (peak[index] > 0)
+      profile.push_back({ (index + 1) * Alloc::align_size, peak[index] });
+  }
+}
+
+/**
+ * @brief print replay report
+ * @param[in] name allocator configuration name
+ * @param[in] report replay report
+ * */
+inline void print_alloc_replay_report(const char* name, const alloc_replay_report& report) {
+  if (!report.heap_measured) {
+    std::printf("%-24s ops=%zu time=%.6fs peak_live=%zu peak_heap=n/a fragmentation=n/a\n",
+                name, report.operations, report.seconds, report.peak_live_bytes);
+    return;
+  }
+  std::printf("%-24s ops=%zu time=%.6fs peak_live=%zu peak_heap=%zu fragmentation=%.2f%%\n",
+              name, report.operations, report.seconds, report.peak_live_bytes,
+              report.peak_heap_bytes, report.fragmentation * 100);
+}
+
+}
+
+#endif // !__STL_ALLOC_REPLAY_H__
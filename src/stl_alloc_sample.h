@@ -0,0 +1,432 @@
+#ifndef __STL_ALLOC_SAMPLE_H__
+#define __STL_ALLOC_SAMPLE_H__
+
+#include <cstdint>
+#include <cstddef>
+
+#ifdef __STL_ALLOC_SAMPLE
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <execinfo.h>
+#endif
+
+namespace stl {
+
+#ifdef __STL_ALLOC_SAMPLE
+
+// sampling heap profiler, about one allocation every rate bytes is sampled
+// every thread count down bytes to next sample, interval is exponential,
+// so sampling is a poisson process and big block is more likely to be taken
+// live samples are kept in fixed table until deallocate, nothing is allocated
+// when recording, profile is dumped in gperftools heap_v2 text format for pprof
+template<int insl>
+class _alloc_sampler_template {
+public:
+  /// default mean bytes between samples, same as tcmalloc
+  static const std::size_t default_rate = 512 * 1024;
+
+public:
+  /**
+   * @brief start sampling, live samples of last run are kept
+   * @param[in] rate mean bytes between samples
+   * */
+  static bool start(std::size_t rate = default_rate) {
+    if (rate == 0)
+      return false;
+    {
+      // first backtrace load unwinder, which allocate, do it out of allocator
+      suspend_guard guard;
+      void* frames[1];
+      ::backtrace(frames, 1);
+    }
+    rate_.store(rate, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief stop taking new samples, live samples are still removed on deallocate
+   * */
+  static void stop() {
+    rate_.store(0, std::memory_order_release);
+  }
+
+  /**
+   * @brief check if sampling now
+   * */
+  static bool sampling() {
+    return rate_.load(std::memory_order_relaxed) != 0;
+  }
+
+  /**
+   * @brief samples dropped because table is full
+   * */
+  static std::size_t dropped() {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief count allocation, one thread local subtraction when not sampled
+   * @param[in] ptr block address
+   * @param[in] size request size
+   * */
+  static void record_allocate(void* ptr, std::size_t size) {
+    bytes_left_ -= std::int64_t(size);
+    if (bytes_left_ > 0 || ptr == nullptr)
+      return;
+    sample(ptr, size);
+  }
+
+  /**
+   * @brief remove sample of block, one load when its bucket hold no sample
+   * @param[in] ptr block address
+   * */
+  static void record_deallocate(void* ptr) {
+    std::size_t bucket = bucket_index(ptr);
+    std::uint64_t bit = std::uint64_t(1) << (bucket % 64);
+    if ((filter_[bucket / 64].load(std::memory_order_relaxed) & bit) == 0)
+      return;
+    remove(ptr, bucket);
+  }
+
+  /**
+   * @brief write live samples to pprof heap profile
+   * @param[in] path profile path
+   * */
+  static bool dump(const char* path) {
+    suspend_guard guard;
+    std::FILE* file = std::fopen(path, "w");
+    if (file == nullptr)
+      return false;
+    dump(file);
+    return std::fclose(file) == 0;
+  }
+
+  /**
+   * @brief write live samples to pprof heap profile, samples of same stack are merged
+   *        counts are raw, pprof scale them back by rate
+   * @param[in] file output file
+   * */
+  static void dump(std::FILE* file) {
+    suspend_guard guard;
+    {
+      table_lock lock;
+      std::size_t count = 0;
+      for (std::int32_t index = 0; index < std::int32_t(max_samples_); index++) {
+        if (samples_[index].ptr != nullptr)
+          order_[count++] = index;
+      }
+      std::sort(order_, order_ + count, [](std::int32_t a, std::int32_t b) {
+        return stack_less(samples_[a], samples_[b]);
+      });
+      std::size_t total_bytes = 0;
+      for (std::size_t index = 0; index < count; index++)
+        total_bytes += samples_[order_[index]].size;
+      std::size_t rate = last_rate_.load(std::memory_order_relaxed);
+      std::fprintf(file, "heap profile: %6zu: %8zu [%6zu: %8zu] @ heap_v2/%zu\n", count,
+                   total_bytes, count, total_bytes, rate);
+      for (std::size_t first = 0; first < count;) {
+        const sample_record& head = samples_[order_[first]];
+        std::size_t last = first;
+        std::size_t bytes = 0;
+        for (; last < count && !stack_less(head, samples_[order_[last]]); last++)
+          bytes += samples_[order_[last]].size;
+        std::fprintf(file, "%6zu: %8zu [%6zu: %8zu] @", last - first, bytes, last - first, bytes);
+        for (std::size_t frame = 0; frame < head.depth; frame++)
+          std::fprintf(file, " %p", head.frames[frame]);
+        std::fprintf(file, "\n");
+        first = last;
+      }
+    }
+    // mapping let pprof symbolize addresses of shared libraries
+#ifdef __linux__
+    std::FILE* maps = std::fopen("/proc/self/maps", "r");
+    if (maps != nullptr) {
+      std::fprintf(file, "\nMAPPED_LIBRARIES:\n");
+      char buffer[4096];
+      std::size_t read = 0;
+      while ((read = std::fread(buffer, 1, sizeof(buffer), maps)) > 0)
+        std::fwrite(buffer, 1, read, file);
+      std::fclose(maps);
+    }
+#endif
+  }
+
+  // stop sampling of current thread in scope, e.g. pool chunk refill
+  // which is not allocation of caller, bytes in scope are not counted
+  struct suspend_guard {
+    suspend_guard() : bytes_left(bytes_left_) { suspended_++; }
+    ~suspend_guard() { suspended_--; bytes_left_ = bytes_left; }
+    /// countdown before scope
+    std::int64_t bytes_left;
+  };
+
+private:
+  // hold mutex and mark this thread as holder, so a free under it, e.g. from fprintf
+  // in dump, remove its record without locking again
+  struct table_lock {
+    table_lock() { mutex_.lock(); holding_ = true; }
+    ~table_lock() { holding_ = false; mutex_.unlock(); }
+  };
+
+  // live sampled block
+  struct sample_record {
+    /// block address, nullptr for free record
+    void* ptr;
+    /// request size
+    std::size_t size;
+    /// next record in bucket chain or free list, -1 for end
+    std::int32_t next;
+    /// frame count
+    std::uint32_t depth;
+    /// return addresses, innermost first
+    void* frames[32];
+  };
+
+  /**
+   * @brief countdown is used up, take sample and draw next interval
+   * @param[in] ptr block address
+   * @param[in] size request size
+   * */
+  static __attribute__((noinline)) void sample(void* ptr, std::size_t size) {
+    std::size_t rate = rate_.load(std::memory_order_relaxed);
+    if (suspended_ > 0)
+      return;
+    if (rate == 0) {
+      // not sampling, recheck after a while so start take effect on every thread
+      bytes_left_ = recheck_bytes_;
+      return;
+    }
+    bool armed = armed_;
+    armed_ = true;
+    bytes_left_ = next_interval(rate);
+    // fresh thread start with zero countdown, its first allocation is not sampled
+    if (!armed)
+      return;
+    sample_record record;
+    record.ptr = ptr;
+    record.size = size;
+    {
+      // skip frame of this function, leaf is the allocator
+      suspend_guard guard;
+      void* frames[max_depth_ + 1];
+      int depth = ::backtrace(frames, int(max_depth_ + 1));
+      record.depth = depth > 1 ? std::uint32_t(depth - 1) : 0;
+      std::copy(frames + 1, frames + 1 + record.depth, record.frames);
+    }
+    table_lock lock;
+    if (free_head_ < 0 && !initialized_)
+      initialize();
+    if (free_head_ < 0) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    std::int32_t index = free_head_;
+    free_head_ = samples_[index].next;
+    std::size_t bucket = bucket_index(ptr);
+    record.next = buckets_[bucket];
+    samples_[index] = record;
+    buckets_[bucket] = index;
+    filter_[bucket / 64].fetch_or(std::uint64_t(1) << (bucket % 64), std::memory_order_relaxed);
+    last_rate_.store(rate, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief remove sample of block if it is sampled, also when sampling is suspended,
+   *        e.g. block freed by oom release handler during chunk refill
+   * @param[in] ptr block address
+   * @param[in] bucket bucket of ptr
+   * */
+  static __attribute__((noinline)) void remove(void* ptr, std::size_t bucket) {
+    if (holding_) {
+      remove_locked(ptr, bucket);
+      return;
+    }
+    table_lock lock;
+    remove_locked(ptr, bucket);
+  }
+
+  /**
+   * @brief remove sample of block, lock must be held
+   * @param[in] ptr block address
+   * @param[in] bucket bucket of ptr
+   * */
+  static void remove_locked(void* ptr, std::size_t bucket) {
+    std::int32_t* link = &buckets_[bucket];
+    while (*link >= 0 && samples_[*link].ptr != ptr)
+      link = &samples_[*link].next;
+    if (*link < 0)
+      return;
+    std::int32_t index = *link;
+    *link = samples_[index].next;
+    samples_[index].ptr = nullptr;
+    samples_[index].next = free_head_;
+    free_head_ = index;
+    if (buckets_[bucket] < 0) {
+      std::uint64_t bit = std::uint64_t(1) << (bucket % 64);
+      filter_[bucket / 64].fetch_and(~bit, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief link all records to free list and clear buckets, lock must be held
+   * */
+  static void initialize() {
+    for (std::size_t index = 0; index < bucket_count_; index++)
+      buckets_[index] = -1;
+    for (std::size_t index = 0; index < max_samples_; index++)
+      samples_[index].next = index + 1 < max_samples_ ? std::int32_t(index + 1) : -1;
+    free_head_ = 0;
+    initialized_ = true;
+  }
+
+  /**
+   * @brief exponential interval with mean rate, from thread local xorshift
+   * @param[in] rate mean bytes between samples
+   * */
+  static std::int64_t next_interval(std::size_t rate) {
+    if (random_ == 0) {
+      random_ = (std::uint64_t)(std::uintptr_t)&random_ ^
+                (std::uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+      random_ |= 1;
+    }
+    random_ ^= random_ >> 12;
+    random_ ^= random_ << 25;
+    random_ ^= random_ >> 27;
+    // 53 bits uniform in (0, 1]
+    double uniform = double(((random_ * 0x2545f4914f6cdd1dull) >> 11) + 1) / 9007199254740992.0;
+    double interval = -std::log(uniform) * double(rate);
+    return interval < 1.0 ? 1 : std::int64_t(interval);
+  }
+
+  /**
+   * @brief hash bucket of block address
+   * @param[in] ptr block address
+   * */
+  static std::size_t bucket_index(void* ptr) {
+    return std::size_t(((std::uint64_t)(std::uintptr_t)ptr * 0x9e3779b97f4a7c15ull) >>
+                       (64 - bucket_bits_));
+  }
+
+  /**
+   * @brief order records by stack, equal stacks are adjacent after sort
+   * @param[in] a record a
+   * @param[in] b record b
+   * */
+  static bool stack_less(const sample_record& a, const sample_record& b) {
+    if (a.depth != b.depth)
+      return a.depth < b.depth;
+    return std::lexicographical_compare(a.frames, a.frames + a.depth, b.frames, b.frames + b.depth);
+  }
+
+private:
+  /// max live samples, about 2GB live heap at default rate
+  static const std::size_t max_samples_ = 4096;
+  /// max frames per sample
+  static const std::size_t max_depth_ = sizeof(sample_record::frames) / sizeof(void*);
+  /// log2 of bucket count
+  static const std::size_t bucket_bits_ = 16;
+  /// bucket count, sparse so most deallocate miss filter
+  static const std::size_t bucket_count_ = std::size_t(1) << bucket_bits_;
+  /// bytes between checks when not sampling
+  static const std::int64_t recheck_bytes_ = 1 << 20;
+  /// mean bytes between samples, 0 when stopped
+  static std::atomic<std::size_t> rate_;
+  /// rate of last sample, written to profile
+  static std::atomic<std::size_t> last_rate_;
+  /// dropped sample count
+  static std::atomic<std::size_t> dropped_;
+  /// protect records, buckets and free list
+  static std::mutex mutex_;
+  /// one bit per bucket, set when bucket hold sample
+  static std::atomic<std::uint64_t> filter_[bucket_count_ / 64];
+  /// bucket chain heads
+  static std::int32_t buckets_[bucket_count_];
+  /// sample records
+  static sample_record samples_[max_samples_];
+  /// dump order of records
+  static std::int32_t order_[max_samples_];
+  /// free record list head
+  static std::int32_t free_head_;
+  /// records are linked to free list
+  static bool initialized_;
+  /// bytes to next sample of this thread
+  static thread_local std::int64_t bytes_left_;
+  /// first interval of this thread is drawn
+  static thread_local bool armed_;
+  /// random state of this thread
+  static thread_local std::uint64_t random_;
+  /// suspend depth of this thread
+  static thread_local int suspended_;
+  /// this thread hold mutex
+  static thread_local bool holding_;
+};
+
+/// init rate
+template<int insl>
+std::atomic<std::size_t> _alloc_sampler_template<insl>::rate_ { 0 };
+/// init last rate
+template<int insl>
+std::atomic<std::size_t> _alloc_sampler_template<insl>::last_rate_ { default_rate };
+/// init dropped count
+template<int insl>
+std::atomic<std::size_t> _alloc_sampler_template<insl>::dropped_ { 0 };
+/// init mutex
+template<int insl>
+std::mutex _alloc_sampler_template<insl>::mutex_;
+/// init filter
+template<int insl>
+std::atomic<std::uint64_t> _alloc_sampler_template<insl>::filter_[bucket_count_ / 64] = {};
+/// init buckets
+template<int insl>
+std::int32_t _alloc_sampler_template<insl>::buckets_[bucket_count_];
+/// init records
+template<int insl>
+typename _alloc_sampler_template<insl>::sample_record
+_alloc_sampler_template<insl>::samples_[max_samples_];
+/// init dump order
+template<int insl>
+std::int32_t _alloc_sampler_template<insl>::order_[max_samples_];
+/// init free head
+template<int insl>
+std::int32_t _alloc_sampler_template<insl>::free_head_ = -1;
+/// init initialized flag
+template<int insl>
+bool _alloc_sampler_template<insl>::initialized_ = false;
+/// init bytes left
+template<int insl>
+thread_local std::int64_t _alloc_sampler_template<insl>::bytes_left_ = 0;
+/// init armed flag
+template<int insl>
+thread_local bool _alloc_sampler_template<insl>::armed_ = false;
+/// init random state
+template<int insl>
+thread_local std::uint64_t _alloc_sampler_template<insl>::random_ = 0;
+/// init suspend depth
+template<int insl>
+thread_local int _alloc_sampler_template<insl>::suspended_ = 0;
+/// init holding flag
+template<int insl>
+thread_local bool _alloc_sampler_template<insl>::holding_ = false;
+
+// redefine alloc sampler
+typedef _alloc_sampler_template<0> alloc_sampler;
+
+#define __STL_SAMPLE_ALLOCATE(ptr, size) stl::alloc_sampler::record_allocate((ptr), (size))
+#define __STL_SAMPLE_DEALLOCATE(ptr) stl::alloc_sampler::record_deallocate(ptr)
+#define __STL_SAMPLE_SUSPEND() stl::alloc_sampler::suspend_guard __stl_sample_guard
+
+#else
+
+#define __STL_SAMPLE_ALLOCATE(ptr, size) ((void)0)
+#define __STL_SAMPLE_DEALLOCATE(ptr) ((void)0)
+#define __STL_SAMPLE_SUSPEND() ((void)0)
+
+#endif // __STL_ALLOC_SAMPLE
+
+}
+
+#endif // !__STL_ALLOC_SAMPLE_H__
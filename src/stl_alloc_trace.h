@@ -0,0 +1,201 @@
+#ifndef __STL_ALLOC_TRACE_H__
+#define __STL_ALLOC_TRACE_H__
+
+#include <cstdint>
+#include <cstddef>
+
+#ifdef __STL_ALLOC_TRACE
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#endif
+
+namespace stl {
+
+// trace operation type
+enum alloc_trace_op : std::uint8_t {
+  trace_allocate = 0,
+  trace_deallocate = 1,
+};
+
+// trace record, fixed 24 bytes in trace file
+struct alloc_trace_record {
+  /// nanoseconds since recording start
+  std::uint64_t timestamp;
+  /// block address, use to pair allocate and deallocate
+  std::uint64_t address;
+  /// request size
+  std::uint32_t size;
+  /// recording thread index
+  std::uint16_t thread;
+  /// alloc_trace_op
+  std::uint8_t op;
+  /// reserved, always 0
+  std::uint8_t reserved;
+};
+
+// trace file header, followed by records
+struct alloc_trace_header {
+  /// always "STLTRACE"
+  char magic[8];
+  /// file format version
+  std::uint32_t version;
+  /// sizeof(alloc_trace_record)
+  std::uint32_t record_size;
+};
+
+/// trace file magic
+static const char alloc_trace_magic[8] = { 'S', 'T', 'L', 'T', 'R', 'A', 'C', 'E' };
+/// trace file version
+static const std::uint32_t alloc_trace_version = 1;
+
+#ifdef __STL_ALLOC_TRACE
+
+template<int insl>
+class _alloc_trace_template {
+public:
+  /**
+   * @brief start recording to file, old content will be truncated
+   * @param[in] path trace file path
+   * */
+  static bool start(const char* path) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (file_ != nullptr)
+      return false;
+    file_ = std::fopen(path, "wb");
+    if (file_ == nullptr)
+      return false;
+    // write header first
+    alloc_trace_header header;
+    std::memcpy(header.magic, alloc_trace_magic, sizeof(header.magic));
+    header.version = alloc_trace_version;
+    header.record_size = sizeof(alloc_trace_record);
+    std::fwrite(&header, sizeof(header), 1, file_);
+    start_time_ = std::chrono::steady_clock::now();
+    buffer_used_ = 0;
+    recording_.store(true, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief stop recording, flush left records and close file
+   * */
+  static void stop() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    recording_.store(false, std::memory_order_release);
+    if (file_ == nullptr)
+      return;
+    flush_buffer();
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+
+  /**
+   * @brief check if recording now
+   * */
+  static bool recording() {
+    return recording_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief record one operation
+   * @param[in] op operation type
+   * @param[in] ptr block address
+   * @param[in] size request size
+   * */
+  static void record(alloc_trace_op op, const void* ptr, std::size_t size) {
+    // fast check, not recording do nothing
+    if (!recording())
+      return;
+    alloc_trace_record rec;
+    rec.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_time_).count();
+    rec.address = (std::uint64_t)(std::uintptr_t)ptr;
+    rec.size = (std::uint32_t)size;
+    rec.thread = thread_index();
+    rec.op = op;
+    rec.reserved = 0;
+    std::lock_guard<std::mutex> guard(mutex_);
+    // may be stopped when wait for lock
+    if (file_ == nullptr)
+      return;
+    buffer_[buffer_used_++] = rec;
+    if (buffer_used_ == buffer_count_)
+      flush_buffer();
+  }
+
+private:
+  /**
+   * @brief write buffer to file, lock must be held
+   * */
+  static void flush_buffer() {
+    if (buffer_used_ > 0)
+      std::fwrite(buffer_, sizeof(alloc_trace_record), buffer_used_, file_);
+    buffer_used_ = 0;
+  }
+
+  /**
+   * @brief get current thread index, start from 0
+   * */
+  static std::uint16_t thread_index() {
+    static std::atomic<std::uint16_t> next_index { 0 };
+    static thread_local std::uint16_t index = next_index++;
+    return index;
+  }
+
+private:
+  /// record count buffered before write
+  static const std::size_t buffer_count_ = 4096;
+  /// protect file and buffer
+  static std::mutex mutex_;
+  /// trace file
+  static std::FILE* file_;
+  /// recording flag
+  static std::atomic<bool> recording_;
+  /// recording start time
+  static std::chrono::steady_clock::time_point start_time_;
+  /// buffered records
+  static alloc_trace_record buffer_[buffer_count_];
+  /// buffered record count
+  static std::size_t buffer_used_;
+};
+
+/// init mutex
+template<int insl>
+std::mutex _alloc_trace_template<insl>::mutex_;
+/// init trace file
+template<int insl>
+std::FILE* _alloc_trace_template<insl>::file_ = nullptr;
+/// init recording flag
+template<int insl>
+std::atomic<bool> _alloc_trace_template<insl>::recording_ { false };
+/// init start time
+template<int insl>
+std::chrono::steady_clock::time_point _alloc_trace_template<insl>::start_time_;
+/// init buffer
+template<int insl>
+alloc_trace_record _alloc_trace_template<insl>::buffer_[buffer_count_];
+/// init buffer used
+template<int insl>
+std::size_t _alloc_trace_template<insl>::buffer_used_ = 0;
+
+// redefine alloc trace
+typedef _alloc_trace_template<0> alloc_trace;
+
+#define __STL_TRACE_ALLOCATE(ptr, size) \
+  stl::alloc_trace::record(stl::trace_allocate, (ptr), (size))
+#define __STL_TRACE_DEALLOCATE(ptr, size) \
+  stl::alloc_trace::record(stl::trace_deallocate, (ptr), (size))
+
+#else
+
+#define __STL_TRACE_ALLOCATE(ptr, size) ((void)0)
+#define __STL_TRACE_DEALLOCATE(ptr, size) ((void)0)
+
+#endif // __STL_ALLOC_TRACE
+
+}
+
+#endif // !__STL_ALLOC_TRACE_H__
@@ -0,0 +1,665 @@
+#ifndef __STL_BIT_VECTOR_H__
+#define __STL_BIT_VECTOR_H__
+
+#include "stl_alloc.h"
+#include "stl_vector.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace stl {
+
+// word level bit helpers
+struct _bit_word {
+  /// bits of one word
+  static const std::size_t bits = 64;
+
+  /**
+   * @brief count set bits of word
+   * @param[in] word word
+   * */
+  static unsigned popcount(std::uint64_t word) {
+    return __builtin_popcountll(word);
+  }
+
+  /**
+   * @brief count set bits of words, independent accumulators keep
+   *        popcnt pipelined, and loop is vectorized when cpu support it
+   * @param[in] words word array
+   * @param[in] count word count
+   * */
+  static std::size_t popcount(const std::uint64_t* words, std::size_t count) {
+    std::size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    std::size_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+      c0 += popcount(words[index]);
+      c1 += popcount(words[index + 1]);
+      c2 += popcount(words[index + 2]);
+      c3 += popcount(words[index + 3]);
+    }
+    for (; index < count; index++)
+      c0 += popcount(words[index]);
+    return c0 + c1 + c2 + c3;
+  }
+
+  /**
+   * @brief position of kth set bit of word, k start from 0 and must be less than popcount
+   * @param[in] word word
+   * @param[in] k set bit rank
+   * */
+  static unsigned select(std::uint64_t word, unsigned k) {
+#if defined(__BMI2__)
+    return __builtin_ctzll(_pdep_u64(std::uint64_t(1) << k, word));
+#else
+    for (; k > 0; k--)
+      word &= word - 1;
+    return __builtin_ctzll(word);
+#endif
+  }
+
+  /**
+   * @brief mask of bits lower than pos
+   * @param[in] pos bit pos in word, in [0, 64)
+   * */
+  static std::uint64_t low_mask(std::size_t pos) {
+    return (std::uint64_t(1) << pos) - 1;
+  }
+};
+
+// reference to one bit of bit_vector
+class bit_reference {
+public:
+  /**
+   * @brief construct
+   * @param[in] word word of bit
+   * @param[in] mask bit mask in word
+   * */
+  bit_reference(std::uint64_t* word, std::uint64_t mask) : word_(word), mask_(mask) {}
+
+  /**
+   * @brief get bit
+   * */
+  operator bool() const {
+    return (*word_ & mask_) != 0;
+  }
+
+  /**
+   * @brief set bit
+   * @param[in] value bit value
+   * */
+  bit_reference& operator=(bool value) {
+    if (value)
+      *word_ |= mask_;
+    else
+      *word_ &= ~mask_;
+    return *this;
+  }
+
+  /**
+   * @brief set bit from other bit
+   * @param[in] other other bit
+   * */
+  bit_reference& operator=(const bit_reference& other) {
+    return *this = bool(other);
+  }
+
+  /**
+   * @brief flip bit
+   * */
+  void flip() {
+    *word_ ^= mask_;
+  }
+
+private:
+  /// word of bit
+  std::uint64_t* word_;
+  /// bit mask in word
+  std::uint64_t mask_;
+};
+
+// bit_vector, bits packed in 64 bit words, bits after size in last word are always zero
+// bulk operations work on whole words
+template<typename Alloc = alloc>
+class bit_vector {
+public:
+  // stl container definition
+  typedef bool value_type;
+  typedef std::size_t size_type;
+  typedef bit_reference reference;
+  typedef bool const_reference;
+
+public:
+  /**
+   * @brief construct empty
+   * */
+  bit_vector() {}
+
+  /**
+   * @brief construct with count bits
+   * @param[in] count bit count
+   * @param[in] value bit value
+   * */
+  explicit bit_vector(size_type count, bool value = false) {
+    resize(count, value);
+  }
+
+public:
+  /**
+   * @brief get bit
+   * @param[in] pos bit pos
+   * */
+  bool operator[] (size_type pos) const {
+    return test(pos);
+  }
+
+  /**
+   * @brief get bit reference
+   * @param[in] pos bit pos
+   * */
+  reference operator[] (size_type pos) {
+    return reference(&words_[pos / _bit_word::bits], std::uint64_t(1) << (pos % _bit_word::bits));
+  }
+
+  /**
+   * @brief get bit with range check
+   * @param[in] pos bit pos
+   * */
+  bool at(size_type pos) const {
+    if (pos >= size_)
+      throw std::out_of_range("bit_vector pos");
+    return test(pos);
+  }
+
+  /**
+   * @brief get bit
+   * @param[in] pos bit pos
+   * */
+  bool test(size_type pos) const {
+    return (words_[pos / _bit_word::bits] >> (pos % _bit_word::bits)) & 1;
+  }
+
+  /**
+   * @brief set bit
+   * @param[in] pos bit pos
+   * */
+  void set(size_type pos) {
+    words_[pos / _bit_word::bits] |= std::uint64_t(1) << (pos % _bit_word::bits);
+  }
+
+  /**
+   * @brief clear bit
+   * @param[in] pos bit pos
+   * */
+  void reset(size_type pos) {
+    words_[pos / _bit_word::bits] &= ~(std::uint64_t(1) << (pos % _bit_word::bits));
+  }
+
+  /**
+   * @brief flip bit
+   * @param[in] pos bit pos
+   * */
+  void flip(size_type pos) {
+    words_[pos / _bit_word::bits] ^= std::uint64_t(1) << (pos % _bit_word::bits);
+  }
+
+  /**
+   * @brief set or clear bits in [first, last), whole words are filled at once
+   * @param[in] first first bit pos
+   * @param[in] last last bit pos
+   * @param[in] value bit value
+   * */
+  void assign_range(size_type first, size_type last, bool value) {
+    if (first >= last)
+      return;
+    size_type first_word = first / _bit_word::bits;
+    size_type last_word = (last - 1) / _bit_word::bits;
+    std::uint64_t head = ~_bit_word::low_mask(first % _bit_word::bits);
+    std::uint64_t tail = ~std::uint64_t(0) >> (_bit_word::bits - 1 - (last - 1) % _bit_word::bits);
+    if (first_word == last_word) {
+      apply_mask(words_[first_word], head & tail, value);
+      return;
+    }
+    apply_mask(words_[first_word], head, value);
+    std::uint64_t fill = value ? ~std::uint64_t(0) : 0;
+    for (size_type index = first_word + 1; index < last_word; index++)
+      words_[index] = fill;
+    apply_mask(words_[last_word], tail, value);
+  }
+
+  /**
+   * @brief set all bits
+   * */
+  void set() {
+    assign_range(0, size_, true);
+  }
+
+  /**
+   * @brief clear all bits
+   * */
+  void reset() {
+    for (size_type index = 0; index < words_.size(); index++)
+      words_[index] = 0;
+  }
+
+  /**
+   * @brief flip all bits
+   * */
+  void flip() {
+    for (size_type index = 0; index < words_.size(); index++)
+      words_[index] = ~words_[index];
+    clear_tail();
+  }
+
+  /**
+   * @brief and with other vector of same size
+   * @param[in] other other vector
+   * */
+  bit_vector& operator&=(const bit_vector& other) {
+    check_size(other);
+    for (size_type index = 0; index < words_.size(); index++)
+      words_[index] &= other.words_[index];
+    return *this;
+  }
+
+  /**
+   * @brief or with other vector of same size
+   * @param[in] other other vector
+   * */
+  bit_vector& operator|=(const bit_vector& other) {
+    check_size(other);
+    for (size_type index = 0; index < words_.size(); index++)
+      words_[index] |= other.words_[index];
+    return *this;
+  }
+
+  /**
+   * @brief xor with other vector of same size
+   * @param[in] other other vector
+   * */
+  bit_vector& operator^=(const bit_vector& other) {
+    check_size(other);
+    for (size_type index = 0; index < words_.size(); index++)
+      words_[index] ^= other.words_[index];
+    return *this;
+  }
+
+  /**
+   * @brief check if same bits
+   * @param[in] other other vector
+   * */
+  bool operator==(const bit_vector& other) const {
+    if (size_ != other.size_)
+      return false;
+    for (size_type index = 0; index < words_.size(); index++) {
+      if (words_[index] != other.words_[index])
+        return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief check if different bits
+   * @param[in] other other vector
+   * */
+  bool operator!=(const bit_vector& other) const {
+    return !(*this == other);
+  }
+
+public:
+  /**
+   * @brief count set bits
+   * */
+  size_type count() const {
+    return _bit_word::popcount(words_.data(), words_.size());
+  }
+
+  /**
+   * @brief count set bits in [0, pos), scan words, use bit_rank_select for repeated query
+   * @param[in] pos bit pos, at most size
+   * */
+  size_type count(size_type pos) const {
+    size_type word = pos / _bit_word::bits;
+    size_type result = _bit_word::popcount(words_.data(), word);
+    if (pos % _bit_word::bits != 0)
+      result += _bit_word::popcount(words_[word] & _bit_word::low_mask(pos % _bit_word::bits));
+    return result;
+  }
+
+  /**
+   * @brief check if any bit set
+   * */
+  bool any() const {
+    for (size_type index = 0; index < words_.size(); index++) {
+      if (words_[index] != 0)
+        return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief check if no bit set
+   * */
+  bool none() const {
+    return !any();
+  }
+
+  /**
+   * @brief find first set bit
+   * @return bit pos, size if not found
+   * */
+  size_type find_first() const {
+    return find_from_word(0);
+  }
+
+  /**
+   * @brief find first set bit after pos
+   * @param[in] pos bit pos
+   * @return bit pos, size if not found
+   * */
+  size_type find_next(size_type pos) const {
+    pos++;
+    if (pos >= size_)
+      return size_;
+    size_type word = pos / _bit_word::bits;
+    std::uint64_t bits = words_[word] & ~_bit_word::low_mask(pos % _bit_word::bits);
+    if (bits != 0)
+      return word * _bit_word::bits + __builtin_ctzll(bits);
+    return find_from_word(word + 1);
+  }
+
+  template<typename Func>
+  /**
+   * @brief call func with pos of every set bit in order, zero words are skipped
+   * @param[in] func func(size_type)
+   * */
+  void for_each_set(Func func) const {
+    for (size_type index = 0; index < words_.size(); index++) {
+      for (std::uint64_t bits = words_[index]; bits != 0; bits &= bits - 1)
+        func(index * _bit_word::bits + __builtin_ctzll(bits));
+    }
+  }
+
+public:
+  /**
+   * @brief push bit to back
+   * @param[in] value bit value
+   * */
+  void push_back(bool value) {
+    if (size_ % _bit_word::bits == 0)
+      words_.push_back(0);
+    if (value)
+      set(size_);
+    size_++;
+  }
+
+  /**
+   * @brief remove back bit
+   * */
+  void pop_back() {
+    resize(size_ - 1);
+  }
+
+  /**
+   * @brief resize, new bits are value
+   * @param[in] count bit count
+   * @param[in] value new bit value
+   * */
+  void resize(size_type count, bool value = false) {
+    size_type old_size = size_;
+    words_.resize(word_count(count), 0);
+    size_ = count;
+    if (count < old_size)
+      clear_tail();
+    else if (value)
+      assign_range(old_size, count, true);
+  }
+
+  /**
+   * @brief reserve storage of count bits
+   * @param[in] count bit count
+   * */
+  void reserve(size_type count) {
+    words_.reserve(word_count(count));
+  }
+
+  /**
+   * @brief remove all bits
+   * */
+  void clear() {
+    words_.clear();
+    size_ = 0;
+  }
+
+  /**
+   * @brief swap with other vector
+   * @param[in] other other vector
+   * */
+  void swap(bit_vector& other) {
+    words_.swap(other.words_);
+    std::swap(size_, other.size_);
+  }
+
+public:
+  /**
+   * @brief bit count
+   * */
+  size_type size() const {
+    return size_;
+  }
+
+  /**
+   * @brief check if empty
+   * */
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  /**
+   * @brief storage words
+   * */
+  const std::uint64_t* data() const {
+    return words_.data();
+  }
+
+  /**
+   * @brief storage words, bits after size must be kept zero
+   * */
+  std::uint64_t* data() {
+    return words_.data();
+  }
+
+  /**
+   * @brief storage word count
+   * */
+  size_type word_count() const {
+    return words_.size();
+  }
+
+  /**
+   * @brief storage bytes
+   * */
+  size_type memory_bytes() const {
+    return words_.size() * sizeof(std::uint64_t);
+  }
+
+private:
+  /**
+   * @brief words needed by count bits
+   * @param[in] count bit count
+   * */
+  static size_type word_count(size_type count) {
+    return (count + _bit_word::bits - 1) / _bit_word::bits;
+  }
+
+  /**
+   * @brief set or clear masked bits of word
+   * @param[in] word word
+   * @param[in] mask bit mask
+   * @param[in] value bit value
+   * */
+  static void apply_mask(std::uint64_t& word, std::uint64_t mask, bool value) {
+    if (value)
+      word |= mask;
+    else
+      word &= ~mask;
+  }
+
+  /**
+   * @brief clear bits after size in last word
+   * */
+  void clear_tail() {
+    if (size_ % _bit_word::bits != 0)
+      words_[words_.size() - 1] &= _bit_word::low_mask(size_ % _bit_word::bits);
+  }
+
+  /**
+   * @brief check other vector has same size
+   * @param[in] other other vector
+   * */
+  void check_size(const bit_vector& other) const {
+    if (size_ != other.size_)
+      throw std::length_error("bit_vector size mismatch");
+  }
+
+  /**
+   * @brief find first set bit from word
+   * @param[in] word word index
+   * */
+  size_type find_from_word(size_type word) const {
+    for (; word < words_.size(); word++) {
+      if (words_[word] != 0)
+        return word * _bit_word::bits + __builtin_ctzll(words_[word]);
+    }
+    return size_;
+  }
+
+private:
+  /// bit words
+  vector<std::uint64_t, Alloc> words_;
+  /// bit count
+  size_type size_ { 0 };
+};
+
+// bit_rank_select, rank and select index over a bit_vector,
+// store set bit count before every 512 bits block, extra space is 1/8 of bits
+// index is not updated by bit_vector modification, call build again after it
+template<typename Alloc = alloc>
+class bit_rank_select {
+public:
+  typedef std::size_t size_type;
+
+  /// words of one block
+  static const size_type block_words = 8;
+
+public:
+  /**
+   * @brief construct empty index
+   * */
+  bit_rank_select() {}
+
+  template<typename BitAlloc>
+  /**
+   * @brief construct and build index
+   * @param[in] bits bit vector, must live longer than index
+   * */
+  explicit bit_rank_select(const bit_vector<BitAlloc>& bits) {
+    build(bits);
+  }
+
+public:
+  template<typename BitAlloc>
+  /**
+   * @brief build index
+   * @param[in] bits bit vector, must live longer than index
+   * */
+  void build(const bit_vector<BitAlloc>& bits) {
+    words_ = bits.data();
+    word_count_ = bits.word_count();
+    size_ = bits.size();
+    size_type block_count = (word_count_ + block_words - 1) / block_words;
+    blocks_.resize(block_count + 1);
+    size_type total = 0;
+    for (size_type block = 0; block < block_count; block++) {
+      blocks_[block] = total;
+      size_type first = block * block_words;
+      size_type count = word_count_ - first < block_words ? word_count_ - first : block_words;
+      total += _bit_word::popcount(words_ + first, count);
+    }
+    blocks_[block_count] = total;
+  }
+
+  /**
+   * @brief count set bits in [0, pos)
+   * @param[in] pos bit pos, at most size
+   * */
+  size_type rank(size_type pos) const {
+    size_type word = pos / _bit_word::bits;
+    size_type block = word / block_words;
+    size_type result = blocks_[block];
+    for (size_type index = block * block_words; index < word; index++)
+      result += _bit_word::popcount(words_[index]);
+    if (pos % _bit_word::bits != 0)
+      result += _bit_word::popcount(words_[word] & _bit_word::low_mask(pos % _bit_word::bits));
+    return result;
+  }
+
+  /**
+   * @brief find pos of kth set bit
+   * @param[in] k set bit rank, start from 0
+   * @return bit pos, size if k is not less than set bit count
+   * */
+  size_type select(size_type k) const {
+    if (k >= count())
+      return size_;
+    // last block whose count before it is not greater than k
+    size_type low = 0;
+    size_type high = blocks_.size() - 1;
+    while (high - low > 1) {
+      size_type middle = low + (high - low) / 2;
+      if (blocks_[middle] <= k)
+        low = middle;
+      else
+        high = middle;
+    }
+    size_type remain = k - blocks_[low];
+    for (size_type index = low * block_words;; index++) {
+      unsigned bits = _bit_word::popcount(words_[index]);
+      if (remain < bits)
+        return index * _bit_word::bits + _bit_word::select(words_[index], unsigned(remain));
+      remain -= bits;
+    }
+  }
+
+  /**
+   * @brief set bit count
+   * */
+  size_type count() const {
+    return blocks_.empty() ? 0 : blocks_[blocks_.size() - 1];
+  }
+
+  /**
+   * @brief index bytes
+   * */
+  size_type memory_bytes() const {
+    return blocks_.size() * sizeof(size_type);
+  }
+
+private:
+  /// indexed words
+  const std::uint64_t* words_ { nullptr };
+  /// indexed word count
+  size_type word_count_ { 0 };
+  /// indexed bit count
+  size_type size_ { 0 };
+  /// set bit count before every block, last one is total
+  vector<size_type, Alloc> blocks_;
+};
+
+}
+
+#endif // !__STL_BIT_VECTOR_H__
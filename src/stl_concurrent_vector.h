@@ -0,0 +1,447 @@
+#ifndef __STL_CONCURRENT_VECTOR_H__
+#define __STL_CONCURRENT_VECTOR_H__
+
+#include "stl_alloc.h"
+#include "stl_construct.h"
+
+#include <new>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+
+namespace stl {
+
+// concurrent_vector, append only vector for many writers
+// storage is power of two segments which never relocate, segment k hold
+// first_segment << k elements, so references stay valid while other threads append
+// push_back claim slot by fetch_add, indexed read is lock-free
+// element at index is readable by other thread once the push_back returned
+// that index, and the index is published to it, e.g. by queue or join
+// a claimed slot can not be given back, so when its segment can not be allocated
+// the whole segment is marked failed and every append landing in it throw bad_alloc,
+// elements of failed segment are never constructed, read or destroyed
+template<typename T, typename Alloc = alloc, std::size_t first_segment = 16>
+class concurrent_vector {
+  static_assert(first_segment > 0 && (first_segment & (first_segment - 1)) == 0,
+                "first segment size must be power of two");
+
+public:
+  // stl container definition
+  typedef T value_type;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+
+protected:
+  typedef simple_alloc<T, Alloc> data_allocator;
+
+public:
+  // random access iterator, indexing through segments
+  template<typename Value, typename Vector>
+  class segment_iterator {
+  public:
+    typedef random_access_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef Value* pointer;
+    typedef Value& reference;
+    typedef Value* pointer_type;
+    typedef Value& reference_type;
+    typedef std::ptrdiff_t difference_type;
+
+  public:
+    segment_iterator() {}
+    segment_iterator(Vector* vector, size_type index) : vector_(vector), index_(index) {}
+
+    reference operator*() const { return (*vector_)[index_]; }
+    pointer operator->() const { return &(*vector_)[index_]; }
+    reference operator[](difference_type n) const { return (*vector_)[index_ + n]; }
+    segment_iterator& operator++() { index_++; return *this; }
+    segment_iterator operator++(int) { segment_iterator tmp = *this; index_++; return tmp; }
+    segment_iterator& operator--() { index_--; return *this; }
+    segment_iterator operator--(int) { segment_iterator tmp = *this; index_--; return tmp; }
+    segment_iterator& operator+=(difference_type n) { index_ += n; return *this; }
+    segment_iterator& operator-=(difference_type n) { index_ -= n; return *this; }
+    segment_iterator operator+(difference_type n) const {
+      return segment_iterator(vector_, index_ + n);
+    }
+    segment_iterator operator-(difference_type n) const {
+      return segment_iterator(vector_, index_ - n);
+    }
+    difference_type operator-(const segment_iterator& other) const {
+      return difference_type(index_) - difference_type(other.index_);
+    }
+    bool operator==(const segment_iterator& other) const { return index_ == other.index_; }
+    bool operator!=(const segment_iterator& other) const { return index_ != other.index_; }
+    bool operator<(const segment_iterator& other) const { return index_ < other.index_; }
+
+  private:
+    /// iterated vector
+    Vector* vector_ { nullptr };
+    /// element index
+    size_type index_ { 0 };
+  };
+
+  typedef segment_iterator<T, concurrent_vector> iterator;
+  typedef segment_iterator<const T, const concurrent_vector> const_iterator;
+
+public:
+  /**
+   * @brief construct empty vector, no segment is allocated
+   * */
+  concurrent_vector() {
+    for (size_type index = 0; index < max_segment_count_; index++)
+      segments_[index].store(nullptr, std::memory_order_relaxed);
+  }
+
+  concurrent_vector(const concurrent_vector&) = delete;
+  concurrent_vector& operator=(const concurrent_vector&) = delete;
+
+  /**
+   * @brief destroy elements and release segments
+   * */
+  ~concurrent_vector() {
+    clear();
+  }
+
+public:
+  /**
+   * @brief append element, safe with other appends and reads
+   * @param[in] value element value
+   * @return element index
+   * */
+  size_type push_back(const T& value) {
+    return emplace_back(value);
+  }
+
+  /**
+   * @brief append element, safe with other appends and reads
+   * @param[in] value element value
+   * @return element index
+   * */
+  size_type push_back(T&& value) {
+    return emplace_back(std::move(value));
+  }
+
+  template<typename... Args>
+  /**
+   * @brief construct element at back, safe with other appends and reads
+   * @param[in] args construct params
+   * @return element index
+   * */
+  size_type emplace_back(Args&&... args) {
+    size_type index = size_.fetch_add(1, std::memory_order_relaxed);
+    T* slot = prepare_slot(index);
+    construct_slot(slot, std::forward<Args>(args)...);
+    return index;
+  }
+
+  /**
+   * @brief append count value initialized elements as one continuous index range
+   * @param[in] count element count
+   * @return first element index
+   * */
+  size_type grow_by(size_type count) {
+    size_type first = size_.fetch_add(count, std::memory_order_relaxed);
+    size_type index = first;
+    try {
+      for (; index < first + count; index++)
+        construct_slot(prepare_slot(index));
+    } catch (...) {
+      // slot at index is in failed segment, the rest are claimed too
+      fill_claimed(index + 1, first + count);
+      throw;
+    }
+    return first;
+  }
+
+  /**
+   * @brief get element, lock-free
+   * @param[in] index element index
+   * */
+  reference operator[] (size_type index) {
+    return *slot(index);
+  }
+
+  /**
+   * @brief get const element, lock-free
+   * @param[in] index element index
+   * */
+  const_reference operator[] (size_type index) const {
+    return *slot(index);
+  }
+
+  /**
+   * @brief get element with range check
+   * @param[in] index element index
+   * */
+  reference at(size_type index) {
+    if (index >= size())
+      throw std::out_of_range("concurrent_vector index");
+    return *slot(index);
+  }
+
+  /**
+   * @brief get const element with range check
+   * @param[in] index element index
+   * */
+  const_reference at(size_type index) const {
+    if (index >= size())
+      throw std::out_of_range("concurrent_vector index");
+    return *slot(index);
+  }
+
+  /**
+   * @brief get begin iterator
+   * */
+  iterator begin() {
+    return iterator(this, 0);
+  }
+
+  /**
+   * @brief get end iterator, elements claimed but not constructed are included
+   * */
+  iterator end() {
+    return iterator(this, size());
+  }
+
+  /**
+   * @brief get const begin iterator
+   * */
+  const_iterator begin() const {
+    return const_iterator(this, 0);
+  }
+
+  /**
+   * @brief get const end iterator
+   * */
+  const_iterator end() const {
+    return const_iterator(this, size());
+  }
+
+public:
+  /**
+   * @brief claimed element count, some may be under construction
+   * */
+  size_type size() const {
+    return size_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief check if empty
+   * */
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /**
+   * @brief element count of allocated segments
+   * */
+  size_type capacity() const {
+    size_type count = 0;
+    for (size_type index = 0; index < max_segment_count_; index++) {
+      T* data = segments_[index].load(std::memory_order_acquire);
+      if (data == nullptr || data == failed_segment())
+        break;
+      count += segment_size(index);
+    }
+    return count;
+  }
+
+  /**
+   * @brief allocate segments to hold count elements, safe with appends
+   *        throw bad_alloc if one of them is failed
+   * @param[in] count element count
+   * */
+  void reserve(size_type count) {
+    if (count == 0)
+      return;
+    size_type last = segment_index(count - 1);
+    for (size_type index = 0; index <= last; index++)
+      segment(index, false);
+  }
+
+  /**
+   * @brief destroy all elements and release segments, failed segments are reset,
+   *        not thread safe
+   * */
+  void clear() {
+    size_type count = size_.load(std::memory_order_acquire);
+    for (size_type index = 0; index < max_segment_count_; index++) {
+      T* data = segments_[index].load(std::memory_order_acquire);
+      if (data == nullptr)
+        continue;
+      if (data == failed_segment()) {
+        segments_[index].store(nullptr, std::memory_order_relaxed);
+        continue;
+      }
+      size_type base = segment_base(index);
+      if (count > base) {
+        size_type used = count - base < segment_size(index) ? count - base : segment_size(index);
+        stl::destroy(data, data + used);
+      }
+      data_allocator::deallocate(data, segment_size(index));
+      segments_[index].store(nullptr, std::memory_order_relaxed);
+    }
+    size_.store(0, std::memory_order_release);
+  }
+
+private:
+  /**
+   * @brief segment holding index
+   * @param[in] index element index
+   * */
+  static size_type segment_index(size_type index) {
+    return size_type(63 - __builtin_clzll((unsigned long long)(index + first_segment))) -
+           first_segment_bits_;
+  }
+
+  /**
+   * @brief first element index of segment
+   * @param[in] index segment index
+   * */
+  static size_type segment_base(size_type index) {
+    return (first_segment << index) - first_segment;
+  }
+
+  /**
+   * @brief element count of segment
+   * @param[in] index segment index
+   * */
+  static size_type segment_size(size_type index) {
+    return first_segment << index;
+  }
+
+  /**
+   * @brief marker of segment which failed to allocate under claimed slots
+   * */
+  static T* failed_segment() {
+    return reinterpret_cast<T*>(std::uintptr_t(alignof(T)));
+  }
+
+  /**
+   * @brief get segment, allocate it if not exist, race is solved by cas
+   * @param[in] index segment index
+   * @param[in] claimed caller hold claimed slot in it, mark segment failed if
+   *            allocation throw, so the slot is never constructed by other thread
+   * */
+  T* segment(size_type index, bool claimed) {
+    T* data = segments_[index].load(std::memory_order_acquire);
+    if (data == failed_segment())
+      throw std::bad_alloc{};
+    if (data != nullptr)
+      return data;
+    T* fresh = nullptr;
+    try {
+      fresh = data_allocator::allocate(segment_size(index));
+    } catch (const std::bad_alloc&) {
+      if (!claimed)
+        throw;
+      // other thread may allocate it meanwhile, then the slot is usable
+      if (!segments_[index].compare_exchange_strong(data, failed_segment(),
+                                                    std::memory_order_acq_rel,
+                                                    std::memory_order_acquire) &&
+          data != failed_segment())
+        return data;
+      throw;
+    }
+    if (segments_[index].compare_exchange_strong(data, fresh, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire))
+      return fresh;
+    // other thread win, data is its segment, or segment is failed
+    data_allocator::deallocate(fresh, segment_size(index));
+    if (data == failed_segment())
+      throw std::bad_alloc{};
+    return data;
+  }
+
+  /**
+   * @brief get slot of claimed index, allocate segment if needed
+   * @param[in] index element index
+   * */
+  T* prepare_slot(size_type index) {
+    size_type seg = segment_index(index);
+    if (seg >= max_segment_count_)
+      throw std::length_error("concurrent_vector too long");
+    return segment(seg, true) + (index - segment_base(seg));
+  }
+
+  /**
+   * @brief get slot of index, segment must exist
+   * @param[in] index element index
+   * */
+  T* slot(size_type index) const {
+    size_type seg = segment_index(index);
+    return segments_[seg].load(std::memory_order_acquire) + (index - segment_base(seg));
+  }
+
+  /**
+   * @brief value initialize claimed slots after an append failed midway,
+   *        slots in failed segment are skipped
+   * @param[in] first first element index
+   * @param[in] last end element index
+   * */
+  void fill_claimed(size_type first, size_type last) {
+    for (size_type index = first; index < last; index++) {
+      try {
+        new ((void*)prepare_slot(index)) T();
+      } catch (const std::bad_alloc&) {
+        // jump to last index of the failed segment
+        size_type seg = segment_index(index);
+        index = segment_base(seg) + segment_size(seg) - 1;
+      } catch (const std::length_error&) {
+        break;
+      }
+    }
+  }
+
+  template<typename... Args>
+  /**
+   * @brief construct element in claimed slot, slot can not be given back,
+   *        so it is value initialized when construction throw
+   * @param[in] slot element slot
+   * @param[in] args construct params
+   * */
+  static void construct_slot(T* slot, Args&&... args) {
+    static_assert(std::is_nothrow_constructible<T, Args...>::value ||
+                  std::is_nothrow_default_constructible<T>::value,
+                  "throwing construct need nothrow default construct to fill the slot");
+    if constexpr (std::is_nothrow_constructible<T, Args...>::value) {
+      new ((void*)slot) T(std::forward<Args>(args)...);
+    } else {
+      try {
+        new ((void*)slot) T(std::forward<Args>(args)...);
+      } catch (...) {
+        new ((void*)slot) T();
+        throw;
+      }
+    }
+  }
+
+  /**
+   * @brief log2 of first segment size
+   * */
+  static constexpr size_type first_segment_bits() {
+    size_type bits = 0;
+    while ((size_type(1) << bits) < first_segment)
+      bits++;
+    return bits;
+  }
+
+private:
+  /// log2 of first segment size
+  static constexpr size_type first_segment_bits_ = first_segment_bits();
+  /// max segment count, covers whole size_type range
+  static constexpr size_type max_segment_count_ = sizeof(size_type) * 8 - first_segment_bits_;
+  /// segments, allocated lazily
+  std::atomic<T*> segments_[max_segment_count_];
+  /// claimed element count
+  std::atomic<size_type> size_ { 0 };
+};
+
+}
+
+#endif // !__STL_CONCURRENT_VECTOR_H__
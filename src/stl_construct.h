@@ -1,8 +1,9 @@
 #ifndef __STL_CONSTRUCT_H__
 #define __STL_CONSTRUCT_H__
 
+#include "stl_trait.h"
+
 #include <new>
-#include <type_traits>
 
 namespace stl {
 
@@ -16,6 +17,15 @@ inline void construct(T* ptr, const U& arg) {
   new (ptr) T(arg);
 }
 
+template<typename T>
+/**
+ * @brief obj construct with value initialization
+ * @param[in] ptr obj address
+ * */
+inline void construct(T* ptr) {
+  new (ptr) T();
+}
+
 template<typename T> 
 /**
  * @brief destroy obj
@@ -31,7 +41,7 @@ template<typename ForwardIterator>
  * @param[in] begin iterator header 
  * @param[in] end iterator tail
  * */
-inline void _destroy_aux(ForwardIterator begin, ForwardIterator end, std::true_type) {}
+inline void _destroy_aux(ForwardIterator /* begin*/, ForwardIterator /* end*/, __true_type) {}
 
 
 template<typename ForwardIterator>
@@ -40,7 +50,7 @@ template<typename ForwardIterator>
  * @param[in] begin iterator header
  * @param[in] end iterator tail
  * */
-inline void _destroy_aux(ForwardIterator begin, ForwardIterator end, std::false_type) {
+inline void _destroy_aux(ForwardIterator begin, ForwardIterator end, __false_type) {
   for (; begin != end; begin++)
     destroy(&*begin);
 }
@@ -53,8 +63,8 @@ template<typename ForwardIterator, typename T>
  * @param[in] T type obj
  * */
 inline void _destroy(ForwardIterator begin, ForwardIterator end, const T*) {
-  typedef std::is_trivial<T> is_trivial;
-  _destroy_aux(begin, end, is_trivial());
+  typedef typename __type_traits<T>::has_trivial_destructor trivial_destructor;
+  _destroy_aux(begin, end, trivial_destructor());
 }
 
 template<typename ForwardIterator>
@@ -64,9 +74,8 @@ template<typename ForwardIterator>
  * @param[in] end iterator tail
  * */
 inline void destroy(ForwardIterator begin, ForwardIterator end) {
-  typedef typename ForwardIterator::value_type value_type;
-  _destroy(begin, end, value_type());  
-  
+  typedef typename iterator_trait<ForwardIterator>::value_type value_type;
+  _destroy(begin, end, (value_type*)nullptr);
 }
 
 
@@ -0,0 +1,649 @@
+#ifndef __STL_FLAT_MAP_H__
+#define __STL_FLAT_MAP_H__
+
+#include "stl_alloc.h"
+#include "stl_vector.h"
+
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+#include <type_traits>
+
+namespace stl {
+
+// search on sorted keys for flat containers
+template<typename Key, typename Compare>
+struct _flat_search {
+  /// window finished by linear scan
+  static const std::size_t scan_width = 16;
+
+  /**
+   * @brief first pos whose key is not less than key
+   *        halving step select base by cmov instead of branch, the last window
+   *        count smaller keys without branch, loop is vectorized for scalar keys
+   * @param[in] keys sorted keys
+   * @param[in] count key count
+   * @param[in] key search key
+   * @param[in] comp key compare
+   * */
+  static std::size_t lower_bound(const Key* keys, std::size_t count, const Key& key,
+                                 const Compare& comp) {
+    const Key* base = keys;
+    std::size_t length = count;
+    while (length > scan_width) {
+      std::size_t half = length / 2;
+      base = comp(base[half - 1], key) ? base + half : base;
+      length -= half;
+    }
+    std::size_t smaller = 0;
+    for (std::size_t index = 0; index < length; index++)
+      smaller += comp(base[index], key) ? 1 : 0;
+    return (base - keys) + smaller;
+  }
+
+  /**
+   * @brief first pos whose key is greater than key
+   * @param[in] keys sorted keys
+   * @param[in] count key count
+   * @param[in] key search key
+   * @param[in] comp key compare
+   * */
+  static std::size_t upper_bound(const Key* keys, std::size_t count, const Key& key,
+                                 const Compare& comp) {
+    const Key* base = keys;
+    std::size_t length = count;
+    while (length > scan_width) {
+      std::size_t half = length / 2;
+      base = !comp(key, base[half - 1]) ? base + half : base;
+      length -= half;
+    }
+    std::size_t not_greater = 0;
+    for (std::size_t index = 0; index < length; index++)
+      not_greater += !comp(key, base[index]) ? 1 : 0;
+    return (base - keys) + not_greater;
+  }
+
+  /**
+   * @brief pos of key
+   * @param[in] keys sorted keys
+   * @param[in] count key count
+   * @param[in] key search key
+   * @param[in] comp key compare
+   * @return pos, count if not found
+   * */
+  static std::size_t find(const Key* keys, std::size_t count, const Key& key, const Compare& comp) {
+    std::size_t pos = lower_bound(keys, count, key, comp);
+    return pos < count && !comp(key, keys[pos]) ? pos : count;
+  }
+};
+
+// flat_set, unique keys sorted in one vector, for read mostly tables
+// single insert and erase are O(n), use build or merge for many keys
+template<typename Key, typename Compare = std::less<Key>, typename Alloc = alloc>
+class flat_set {
+public:
+  // stl container definition
+  typedef Key key_type;
+  typedef Key value_type;
+  typedef Compare key_compare;
+  typedef std::size_t size_type;
+  typedef const Key* iterator;
+  typedef const Key* const_iterator;
+
+protected:
+  typedef _flat_search<Key, Compare> search;
+
+public:
+  /**
+   * @brief construct empty set
+   * @param[in] comp key compare
+   * */
+  explicit flat_set(const Compare& comp = Compare()) : comp_(comp) {}
+
+  /**
+   * @brief construct from keys
+   * @param[in] keys key array
+   * @param[in] count key count
+   * @param[in] comp key compare
+   * */
+  flat_set(const Key* keys, size_type count, const Compare& comp = Compare()) : comp_(comp) {
+    build(keys, count);
+  }
+
+public:
+  /**
+   * @brief replace content, keys are sorted and deduplicated at once
+   * @param[in] keys key array
+   * @param[in] count key count
+   * */
+  void build(const Key* keys, size_type count) {
+    keys_.clear();
+    keys_.reserve(count);
+    for (size_type index = 0; index < count; index++)
+      keys_.push_back(keys[index]);
+    sort_unique(keys_);
+  }
+
+  /**
+   * @brief merge keys, batch is sorted then merged in one pass
+   * @param[in] keys key array
+   * @param[in] count key count
+   * */
+  void merge(const Key* keys, size_type count) {
+    vector<Key, Alloc> batch;
+    batch.reserve(count);
+    for (size_type index = 0; index < count; index++)
+      batch.push_back(keys[index]);
+    sort_unique(batch);
+    vector<Key, Alloc> merged;
+    merged.reserve(keys_.size() + batch.size());
+    size_type left = 0;
+    size_type right = 0;
+    while (left < keys_.size() && right < batch.size()) {
+      if (comp_(keys_[left], batch[right])) {
+        merged.push_back(keys_[left++]);
+      } else if (comp_(batch[right], keys_[left])) {
+        merged.push_back(batch[right++]);
+      } else {
+        merged.push_back(keys_[left++]);
+        right++;
+      }
+    }
+    for (; left < keys_.size(); left++)
+      merged.push_back(keys_[left]);
+    for (; right < batch.size(); right++)
+      merged.push_back(batch[right]);
+    keys_.swap(merged);
+  }
+
+  /**
+   * @brief insert one key
+   * @param[in] key key
+   * @return pos of key and if it is inserted
+   * */
+  std::pair<iterator, bool> insert(const Key& key) {
+    size_type pos = search::lower_bound(keys_.data(), keys_.size(), key, comp_);
+    if (pos < keys_.size() && !comp_(key, keys_[pos]))
+      return std::make_pair(begin() + pos, false);
+    keys_.insert(keys_.begin() + pos, key);
+    return std::make_pair(begin() + pos, true);
+  }
+
+  /**
+   * @brief erase key
+   * @param[in] key key
+   * @return erased count
+   * */
+  size_type erase(const Key& key) {
+    size_type pos = search::find(keys_.data(), keys_.size(), key, comp_);
+    if (pos == keys_.size())
+      return 0;
+    keys_.erase(keys_.begin() + pos);
+    return 1;
+  }
+
+  /**
+   * @brief find key
+   * @param[in] key key
+   * @return pos, end if not found
+   * */
+  iterator find(const Key& key) const {
+    return begin() + search::find(keys_.data(), keys_.size(), key, comp_);
+  }
+
+  /**
+   * @brief check if key exist
+   * @param[in] key key
+   * */
+  bool contains(const Key& key) const {
+    return find(key) != end();
+  }
+
+  /**
+   * @brief count key, 0 or 1
+   * @param[in] key key
+   * */
+  size_type count(const Key& key) const {
+    return contains(key) ? 1 : 0;
+  }
+
+  /**
+   * @brief first key not less than key
+   * @param[in] key key
+   * */
+  iterator lower_bound(const Key& key) const {
+    return begin() + search::lower_bound(keys_.data(), keys_.size(), key, comp_);
+  }
+
+  /**
+   * @brief first key greater than key
+   * @param[in] key key
+   * */
+  iterator upper_bound(const Key& key) const {
+    return begin() + search::upper_bound(keys_.data(), keys_.size(), key, comp_);
+  }
+
+public:
+  /**
+   * @brief get begin iterator
+   * */
+  iterator begin() const {
+    return keys_.data();
+  }
+
+  /**
+   * @brief get end iterator
+   * */
+  iterator end() const {
+    return keys_.data() + keys_.size();
+  }
+
+  /**
+   * @brief key count
+   * */
+  size_type size() const {
+    return keys_.size();
+  }
+
+  /**
+   * @brief check if empty
+   * */
+  bool empty() const {
+    return keys_.empty();
+  }
+
+  /**
+   * @brief reserve storage of count keys
+   * @param[in] count key count
+   * */
+  void reserve(size_type count) {
+    keys_.reserve(count);
+  }
+
+  /**
+   * @brief remove all keys
+   * */
+  void clear() {
+    keys_.clear();
+  }
+
+  /**
+   * @brief storage bytes
+   * */
+  size_type memory_bytes() const {
+    return keys_.capacity() * sizeof(Key);
+  }
+
+private:
+  /**
+   * @brief sort keys and remove duplicate, first one is kept
+   * @param[in] keys keys
+   * */
+  void sort_unique(vector<Key, Alloc>& keys) {
+    std::stable_sort(keys.begin(), keys.end(), comp_);
+    const Compare& comp = comp_;
+    Key* last = std::unique(keys.begin(), keys.end(), [&comp](const Key& left, const Key& right) {
+      return !comp(left, right) && !comp(right, left);
+    });
+    keys.erase(last, keys.end());
+  }
+
+private:
+  /// sorted unique keys
+  vector<Key, Alloc> keys_;
+  /// key compare
+  Compare comp_;
+};
+
+// flat_map, keys and values in separate sorted vectors,
+// search touch only keys, so more keys share one cache line
+// single insert and erase are O(n), use build or merge for many pairs
+template<typename Key, typename Value, typename Compare = std::less<Key>, typename Alloc = alloc>
+class flat_map {
+public:
+  // stl container definition
+  typedef Key key_type;
+  typedef Value mapped_type;
+  typedef Compare key_compare;
+  typedef std::size_t size_type;
+
+  /// not found pos
+  static const size_type npos = size_type(-1);
+
+protected:
+  typedef _flat_search<Key, Compare> search;
+
+public:
+  /**
+   * @brief construct empty map
+   * @param[in] comp key compare
+   * */
+  explicit flat_map(const Compare& comp = Compare()) : comp_(comp) {}
+
+public:
+  /**
+   * @brief replace content, pairs are sorted and deduplicated at once,
+   *        last value of same key is kept
+   * @param[in] pairs key value pairs
+   * @param[in] count pair count
+   * */
+  void build(const std::pair<Key, Value>* pairs, size_type count) {
+    keys_.clear();
+    values_.clear();
+    merge(pairs, count);
+  }
+
+  /**
+   * @brief merge pairs, batch is sorted then merged in one pass,
+   *        value of batch replace exist value of same key
+   * @param[in] pairs key value pairs
+   * @param[in] count pair count
+   * */
+  void merge(const std::pair<Key, Value>* pairs, size_type count) {
+    // sort batch by index, last pair of same key win
+    vector<size_type, Alloc> order;
+    order.reserve(count);
+    for (size_type index = 0; index < count; index++)
+      order.push_back(index);
+    const Compare& comp = comp_;
+    std::stable_sort(order.begin(), order.end(), [pairs, &comp](size_type left, size_type right) {
+      return comp(pairs[left].first, pairs[right].first);
+    });
+    vector<Key, Alloc> keys;
+    vector<Value, Alloc> values;
+    keys.reserve(keys_.size() + count);
+    values.reserve(keys_.size() + count);
+    size_type left = 0;
+    size_type right = 0;
+    while (left < keys_.size() || right < count) {
+      if (right == count || (left < keys_.size() && comp_(keys_[left], pairs[order[right]].first))) {
+        keys.push_back(keys_[left]);
+        values.push_back(values_[left]);
+        left++;
+        continue;
+      }
+      // skip to last pair of same key in batch
+      while (right + 1 < count && !comp_(pairs[order[right]].first, pairs[order[right + 1]].first))
+        right++;
+      const std::pair<Key, Value>& pair = pairs[order[right++]];
+      if (left < keys_.size() && !comp_(pair.first, keys_[left]))
+        left++;
+      keys.push_back(pair.first);
+      values.push_back(pair.second);
+    }
+    keys_.swap(keys);
+    values_.swap(values);
+  }
+
+  /**
+   * @brief insert pair if key not exist
+   * @param[in] key key
+   * @param[in] value value
+   * @return if it is inserted
+   * */
+  bool insert(const Key& key, const Value& value) {
+    size_type pos = search::lower_bound(keys_.data(), keys_.size(), key, comp_);
+    if (pos < keys_.size() && !comp_(key, keys_[pos]))
+      return false;
+    insert_at(pos, key, value);
+    return true;
+  }
+
+  /**
+   * @brief insert pair or replace value
+   * @param[in] key key
+   * @param[in] value value
+   * @return if it is inserted
+   * */
+  bool insert_or_assign(const Key& key, const Value& value) {
+    size_type pos = search::lower_bound(keys_.data(), keys_.size(), key, comp_);
+    if (pos < keys_.size() && !comp_(key, keys_[pos])) {
+      values_[pos] = value;
+      return false;
+    }
+    insert_at(pos, key, value);
+    return true;
+  }
+
+  /**
+   * @brief erase key
+   * @param[in] key key
+   * @return erased count
+   * */
+  size_type erase(const Key& key) {
+    size_type pos = index_of(key);
+    if (pos == npos)
+      return 0;
+    keys_.erase(keys_.begin() + pos);
+    values_.erase(values_.begin() + pos);
+    return 1;
+  }
+
+  /**
+   * @brief get value of key, insert default value if not exist
+   * @param[in] key key
+   * */
+  Value& operator[] (const Key& key) {
+    size_type pos = search::lower_bound(keys_.data(), keys_.size(), key, comp_);
+    if (pos == keys_.size() || comp_(key, keys_[pos])) {
+      insert_at(pos, key, Value());
+    }
+    return values_[pos];
+  }
+
+  /**
+   * @brief get value of key
+   * @param[in] key key
+   * */
+  Value& at(const Key& key) {
+    Value* value = find(key);
+    if (value == nullptr)
+      throw std::out_of_range("flat_map key");
+    return *value;
+  }
+
+  /**
+   * @brief get const value of key
+   * @param[in] key key
+   * */
+  const Value& at(const Key& key) const {
+    const Value* value = find(key);
+    if (value == nullptr)
+      throw std::out_of_range("flat_map key");
+    return *value;
+  }
+
+  /**
+   * @brief find value of key
+   * @param[in] key key
+   * @return value, nullptr if not found
+   * */
+  Value* find(const Key& key) {
+    size_type pos = index_of(key);
+    return pos == npos ? nullptr : &values_[pos];
+  }
+
+  /**
+   * @brief find const value of key
+   * @param[in] key key
+   * @return value, nullptr if not found
+   * */
+  const Value* find(const Key& key) const {
+    size_type pos = index_of(key);
+    return pos == npos ? nullptr : &values_[pos];
+  }
+
+  /**
+   * @brief check if key exist
+   * @param[in] key key
+   * */
+  bool contains(const Key& key) const {
+    return index_of(key) != npos;
+  }
+
+  /**
+   * @brief count key, 0 or 1
+   * @param[in] key key
+   * */
+  size_type count(const Key& key) const {
+    return contains(key) ? 1 : 0;
+  }
+
+  /**
+   * @brief pos of key in sorted order
+   * @param[in] key key
+   * @return pos, npos if not found
+   * */
+  size_type index_of(const Key& key) const {
+    size_type pos = search::find(keys_.data(), keys_.size(), key, comp_);
+    return pos == keys_.size() ? npos : pos;
+  }
+
+  /**
+   * @brief first pos whose key is not less than key
+   * @param[in] key key
+   * */
+  size_type lower_bound(const Key& key) const {
+    return search::lower_bound(keys_.data(), keys_.size(), key, comp_);
+  }
+
+  /**
+   * @brief first pos whose key is greater than key
+   * @param[in] key key
+   * */
+  size_type upper_bound(const Key& key) const {
+    return search::upper_bound(keys_.data(), keys_.size(), key, comp_);
+  }
+
+  template<typename Func>
+  /**
+   * @brief call func with every pair in key order
+   * @param[in] func func(const Key&, Value&)
+   * */
+  void for_each(Func func) {
+    for (size_type index = 0; index < keys_.size(); index++)
+      func(keys_[index], values_[index]);
+  }
+
+  template<typename Func>
+  /**
+   * @brief call func with every pair in key order
+   * @param[in] func func(const Key&, const Value&)
+   * */
+  void for_each(Func func) const {
+    for (size_type index = 0; index < keys_.size(); index++)
+      func(keys_[index], values_[index]);
+  }
+
+public:
+  /**
+   * @brief key at pos
+   * @param[in] pos pos in key order
+   * */
+  const Key& key(size_type pos) const {
+    return keys_[pos];
+  }
+
+  /**
+   * @brief value at pos
+   * @param[in] pos pos in key order
+   * */
+  Value& value(size_type pos) {
+    return values_[pos];
+  }
+
+  /**
+   * @brief const value at pos
+   * @param[in] pos pos in key order
+   * */
+  const Value& value(size_type pos) const {
+    return values_[pos];
+  }
+
+  /**
+   * @brief sorted keys
+   * */
+  const vector<Key, Alloc>& keys() const {
+    return keys_;
+  }
+
+  /**
+   * @brief values in key order
+   * */
+  const vector<Value, Alloc>& values() const {
+    return values_;
+  }
+
+  /**
+   * @brief pair count
+   * */
+  size_type size() const {
+    return keys_.size();
+  }
+
+  /**
+   * @brief check if empty
+   * */
+  bool empty() const {
+    return keys_.empty();
+  }
+
+  /**
+   * @brief reserve storage of count pairs
+   * @param[in] count pair count
+   * */
+  void reserve(size_type count) {
+    keys_.reserve(count);
+    values_.reserve(count);
+  }
+
+  /**
+   * @brief remove all pairs
+   * */
+  void clear() {
+    keys_.clear();
+    values_.clear();
+  }
+
+  /**
+   * @brief storage bytes
+   * */
+  size_type memory_bytes() const {
+    return keys_.capacity() * sizeof(Key) + values_.capacity() * sizeof(Value);
+  }
+
+private:
+  /**
+   * @brief insert pair at pos, key is erased again if value insert throw
+   * @param[in] pos pos in key order
+   * @param[in] key key
+   * @param[in] value value
+   * */
+  void insert_at(size_type pos, const Key& key, const Value& value) {
+    keys_.insert(keys_.begin() + pos, key);
+    try {
+      values_.insert(values_.begin() + pos, value);
+    } catch (...) {
+      keys_.erase(keys_.begin() + pos);
+      throw;
+    }
+  }
+
+private:
+  /// sorted unique keys
+  vector<Key, Alloc> keys_;
+  /// values in key order
+  vector<Value, Alloc> values_;
+  /// key compare
+  Compare comp_;
+};
+
+/// init npos
+template<typename Key, typename Value, typename Compare, typename Alloc>
+const typename flat_map<Key, Value, Compare, Alloc>::size_type flat_map<Key, Value, Compare, Alloc>::npos;
+
+}
+
+#endif // !__STL_FLAT_MAP_H__
@@ -0,0 +1,56 @@
+#ifndef __STL_MEMORY_RESOURCE_H__
+#define __STL_MEMORY_RESOURCE_H__
+
+#include "stl_alloc.h"
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace stl {
+
+// pool_memory_resource, std::pmr::memory_resource over Alloc,
+// use it directly or as upstream of std::pmr::monotonic_buffer_resource
+// to get region allocation whose chunks come from pool
+template<typename Alloc = alloc>
+class pool_memory_resource : public std::pmr::memory_resource {
+protected:
+  /**
+   * @brief allocate aligned memory from Alloc
+   * @param[in] bytes alloc size
+   * @param[in] alignment memory align
+   * */
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    return Alloc::allocate(bytes, alignment);
+  }
+
+  /**
+   * @brief deallocate memory to Alloc
+   * @param[in] ptr memory address
+   * @param[in] bytes memory size
+   * @param[in] alignment memory align
+   * */
+  void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override {
+    Alloc::deallocate(ptr, bytes, alignment);
+  }
+
+  /**
+   * @brief resources over same Alloc share same static pool
+   * @param[in] other other resource
+   * */
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return dynamic_cast<const pool_memory_resource*>(&other) != nullptr;
+  }
+};
+
+template<typename Alloc = alloc>
+/**
+ * @brief get process wide resource over Alloc
+ * */
+inline pool_memory_resource<Alloc>* pool_resource() {
+  static pool_memory_resource<Alloc> resource;
+  return &resource;
+}
+
+}
+
+#endif // !__STL_MEMORY_RESOURCE_H__
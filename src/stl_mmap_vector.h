@@ -0,0 +1,395 @@
+#ifndef __STL_MMAP_VECTOR_H__
+#define __STL_MMAP_VECTOR_H__
+
+#include <new>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace stl {
+
+// mmap_vector, vector backed by memory mapped file
+// open map the file directly, so load time does not depend on file size
+// file size is size() * sizeof(T) after close, before it the file keeps the
+// zero tail of reserved capacity, flush only write pages back
+template<typename T>
+class mmap_vector {
+  static_assert(std::is_trivially_copyable<T>::value, "mmap_vector require trivially copyable type");
+
+public:
+  // stl container definition
+  typedef T value_type;
+  typedef T* pointer;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+
+  // file open mode
+  enum open_mode {
+    /// read only, write to element is not allowed
+    read_only,
+    /// private writable map, change never write back to file, can not grow
+    copy_on_write,
+    /// shared writable map, can grow by extending file
+    read_write,
+  };
+
+public:
+  /**
+   * @brief construct
+   * */
+  mmap_vector() {}
+
+  /**
+   * @brief construct and open file
+   * @param[in] path file path
+   * @param[in] mode open mode
+   * */
+  mmap_vector(const char* path, open_mode mode) {
+    if (!open(path, mode))
+      throw std::runtime_error("mmap_vector open");
+  }
+
+  /**
+   * @brief move construct
+   * */
+  mmap_vector(mmap_vector&& other) noexcept {
+    swap(other);
+  }
+
+  /**
+   * @brief move assign
+   * */
+  mmap_vector& operator=(mmap_vector&& other) noexcept {
+    if (this != &other) {
+      close();
+      swap(other);
+    }
+    return *this;
+  }
+
+  mmap_vector(const mmap_vector&) = delete;
+  mmap_vector& operator=(const mmap_vector&) = delete;
+
+  /**
+   * @brief unmap and close file
+   * */
+  ~mmap_vector() {
+    close();
+  }
+
+public:
+  /**
+   * @brief open and map file, read_write mode create file if not exist
+   * @param[in] path file path
+   * @param[in] mode open mode
+   * */
+  bool open(const char* path, open_mode mode) {
+    close();
+    int flags = mode == read_write ? O_RDWR | O_CREAT : O_RDONLY;
+    int fd = ::open(path, flags, 0644);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      return false;
+    }
+    fd_ = fd;
+    mode_ = mode;
+    size_type count = size_type(st.st_size) / sizeof(T);
+    // map whole file, empty file has nothing to map
+    if (count > 0 && !map(count)) {
+      close();
+      return false;
+    }
+    size_ = count;
+    return true;
+  }
+
+  /**
+   * @brief unmap and close file, drop reserved tail of file
+   * */
+  void close() {
+    if (fd_ < 0)
+      return;
+    if (mode_ == read_write && capacity_ != size_)
+      (void)::ftruncate(fd_, off_t(size_ * sizeof(T)));
+    unmap();
+    ::close(fd_);
+    fd_ = -1;
+    size_ = 0;
+  }
+
+  /**
+   * @brief check if file is opened
+   * */
+  bool is_open() const {
+    return fd_ >= 0;
+  }
+
+  /**
+   * @brief write dirty pages to file, file is not truncated,
+   *        it still hold reserved capacity until close
+   * @param[in] async schedule write and return immediately
+   * */
+  bool flush(bool async = false) {
+    if (mode_ != read_write || start_ == nullptr)
+      return true;
+    return ::msync(start_, capacity_ * sizeof(T), async ? MS_ASYNC : MS_SYNC) == 0;
+  }
+
+public:
+  /**
+   * @brief get begin iterator
+   * */
+  iterator begin() { return start_; }
+
+  /**
+   * @brief get end iterator
+   * */
+  iterator end() { return start_ + size_; }
+
+  /**
+   * @brief get begin iterator
+   * */
+  const_iterator begin() const { return start_; }
+
+  /**
+   * @brief get end iterator
+   * */
+  const_iterator end() const { return start_ + size_; }
+
+  // element access
+public:
+  /**
+   * @brief get index element
+   * @param[in] index element index
+   * */
+  reference at(size_type index) {
+    if (index >= size_)
+      throw std::out_of_range("mmap_vector index");
+    return start_[index];
+  }
+
+  /**
+   * @brief get index element
+   * @param[in] index element index
+   * */
+  reference operator[] (size_type index) {
+    return start_[index];
+  }
+
+  /**
+   * @brief get index element
+   * @param[in] index element index
+   * */
+  const_reference operator[] (size_type index) const {
+    return start_[index];
+  }
+
+  /**
+   * @brief get front element
+   * */
+  reference front() {
+    return *start_;
+  }
+
+  /**
+   * @brief get back element
+   * */
+  reference back() {
+    return start_[size_ - 1];
+  }
+
+  /**
+   * @brief get mapped address
+   * */
+  T* data() {
+    return start_;
+  }
+
+  /**
+   * @brief get mapped address
+   * */
+  const T* data() const {
+    return start_;
+  }
+
+  // capacity
+public:
+  /**
+   * @brief check if vec is empty
+   * */
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  /**
+   * @brief element count
+   * */
+  size_type size() const {
+    return size_;
+  }
+
+  /**
+   * @brief mapped element count
+   * */
+  size_type capacity() const {
+    return capacity_;
+  }
+
+  /**
+   * @brief extend file and remap, only for read_write mode
+   * @param[in] count element count
+   * */
+  void reserve(size_type count) {
+    if (count <= capacity_)
+      return;
+    check_writable();
+    if (::ftruncate(fd_, off_t(count * sizeof(T))) != 0)
+      throw std::bad_alloc{};
+    if (!map(count))
+      throw std::bad_alloc{};
+  }
+
+  /**
+   * @brief resize, new elements are zero filled, read_only map can only shrink
+   * @param[in] count element count
+   * */
+  void resize(size_type count) {
+    if (count > size_)
+      check_mutable();
+    if (count > capacity_)
+      reserve(count);
+    // tail within capacity may hold elements removed before
+    if (count > size_)
+      std::memset((void*)(start_ + size_), 0, (count - size_) * sizeof(T));
+    size_ = count;
+  }
+
+  // modifier
+public:
+  /**
+   * @brief push value to back, grow file twice when full
+   * @param[in] value back value
+   * */
+  void push_back(const T& value) {
+    // spare capacity of read_only map is still a read only page
+    check_mutable();
+    if (size_ == capacity_)
+      reserve(capacity_ == 0 ? page_elements() : capacity_ * 2);
+    start_[size_++] = value;
+  }
+
+  /**
+   * @brief remove back element
+   * */
+  void pop_back() {
+    --size_;
+  }
+
+  /**
+   * @brief remove all element, file is truncated when close
+   * */
+  void clear() {
+    size_ = 0;
+  }
+
+  /**
+   * @brief swap with other
+   * @param[in] other other vector
+   * */
+  void swap(mmap_vector& other) noexcept {
+    std::swap(start_, other.start_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(fd_, other.fd_);
+    std::swap(mode_, other.mode_);
+  }
+
+private:
+  /**
+   * @brief map count elements of file, replace old map
+   * @param[in] count element count
+   * */
+  bool map(size_type count) {
+    int prot = mode_ == read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+    int flags = mode_ == read_write ? MAP_SHARED : MAP_PRIVATE;
+    void* addr = MAP_FAILED;
+#ifdef __linux__
+    // remap keep page table and may avoid moving
+    if (start_ != nullptr)
+      addr = ::mremap(start_, capacity_ * sizeof(T), count * sizeof(T), MREMAP_MAYMOVE);
+#endif
+    if (addr == MAP_FAILED) {
+      addr = ::mmap(nullptr, count * sizeof(T), prot, flags, fd_, 0);
+      if (addr == MAP_FAILED)
+        return false;
+      unmap();
+    }
+    start_ = (T*)addr;
+    capacity_ = count;
+    return true;
+  }
+
+  /**
+   * @brief unmap current map
+   * */
+  void unmap() {
+    if (start_ != nullptr)
+      ::munmap(start_, capacity_ * sizeof(T));
+    start_ = nullptr;
+    capacity_ = 0;
+  }
+
+  /**
+   * @brief only read_write map can grow
+   * */
+  void check_writable() {
+    if (mode_ != read_write)
+      throw std::logic_error("mmap_vector is not opened as read_write");
+  }
+
+  /**
+   * @brief read_only map can not be written, even within capacity
+   * */
+  void check_mutable() {
+    if (mode_ == read_only)
+      throw std::logic_error("mmap_vector is opened as read_only");
+  }
+
+  /**
+   * @brief element count of one page, at least 1
+   * */
+  static size_type page_elements() {
+    size_type count = size_type(::sysconf(_SC_PAGESIZE)) / sizeof(T);
+    return count == 0 ? 1 : count;
+  }
+
+private:
+  /// map address
+  T* start_ { nullptr };
+  /// element count
+  size_type size_ { 0 };
+  /// mapped element count
+  size_type capacity_ { 0 };
+  /// file descriptor
+  int fd_ { -1 };
+  /// open mode
+  open_mode mode_ { read_only };
+};
+
+}
+
+#endif // !__STL_MMAP_VECTOR_H__
@@ -0,0 +1,559 @@
+#ifndef __STL_PACKED_VECTOR_H__
+#define __STL_PACKED_VECTOR_H__
+
+#include "stl_alloc.h"
+#include "stl_vector.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+
+namespace stl {
+
+// bit packing kernels, values are packed from low bit to high bit,
+// 64 values of width bits occupy exactly width words
+struct _bit_pack {
+  /// unpack 64 values
+  typedef void (*unpack_func)(const std::uint64_t* in, std::uint64_t* out);
+
+  /**
+   * @brief get mask of width bits
+   * @param[in] width bit width
+   * */
+  static constexpr std::uint64_t mask(unsigned width) {
+    return width >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << width) - 1;
+  }
+
+  /**
+   * @brief get bits needed by value
+   * @param[in] value value
+   * */
+  static unsigned bit_width(std::uint64_t value) {
+    return value == 0 ? 0 : 64 - __builtin_clzll(value);
+  }
+
+  /**
+   * @brief get words needed by count values
+   * @param[in] count value count
+   * @param[in] width bit width
+   * */
+  static std::size_t word_count(std::size_t count, unsigned width) {
+    return (count * width + 63) / 64;
+  }
+
+  /**
+   * @brief read one value
+   * @param[in] words packed words, one more word after last value must be readable
+   * @param[in] bit value bit position
+   * @param[in] width bit width, width 0 read nothing
+   * */
+  static std::uint64_t read(const std::uint64_t* words, std::size_t bit, unsigned width) {
+    // width 0 value own no word, the following one may be out of storage
+    if (width == 0)
+      return 0;
+    std::size_t word = bit >> 6;
+    unsigned offset = bit & 63;
+    // shift twice, so offset 0 never shift 64
+    std::uint64_t value = (words[word] >> offset) | ((words[word + 1] << 1) << (63 - offset));
+    return value & mask(width);
+  }
+
+  /**
+   * @brief write one value, value must fit in width
+   * @param[in] words packed words
+   * @param[in] bit value bit position
+   * @param[in] value value
+   * @param[in] width bit width
+   * */
+  static void write(std::uint64_t* words, std::size_t bit, std::uint64_t value, unsigned width) {
+    if (width == 0)
+      return;
+    std::size_t word = bit >> 6;
+    unsigned offset = bit & 63;
+    words[word] = (words[word] & ~(mask(width) << offset)) | (value << offset);
+    if (offset + width > 64) {
+      unsigned shift = 64 - offset;
+      words[word + 1] = (words[word + 1] & ~(mask(width) >> shift)) | (value >> shift);
+    }
+  }
+
+  template<unsigned width>
+  /**
+   * @brief unpack 64 values, width is constant so loop is unrolled to
+   *        straight shift and mask code which compiler can vectorize
+   * @param[in] in packed words
+   * @param[out] out values
+   * */
+  static void unpack_block(const std::uint64_t* in, std::uint64_t* out) {
+    if (width == 0) {
+      for (unsigned index = 0; index < 64; index++)
+        out[index] = 0;
+      return;
+    }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC unroll 64
+#endif
+    for (unsigned index = 0; index < 64; index++) {
+      unsigned bit = index * width;
+      unsigned word = bit >> 6;
+      unsigned offset = bit & 63;
+      std::uint64_t value = in[word] >> offset;
+      if (offset + width > 64)
+        value |= in[word + 1] << (64 - offset);
+      out[index] = value & mask(width);
+    }
+  }
+
+  template<std::size_t... widths>
+  /**
+   * @brief build unpack table of every width
+   * */
+  static const unpack_func* make_table(std::index_sequence<widths...>) {
+    static const unpack_func table[] = { &unpack_block<widths>... };
+    return table;
+  }
+
+  /**
+   * @brief get unpack func of width
+   * @param[in] width bit width, in [0, 64]
+   * */
+  static unpack_func unpacker(unsigned width) {
+    static const unpack_func* table = make_table(std::make_index_sequence<65>());
+    return table[width];
+  }
+};
+
+// packed_vector, unsigned integers packed with same bit width
+// width is chosen automatically by largest value, and grow on demand
+template<typename T = std::uint64_t, typename Alloc = alloc>
+class packed_vector {
+  static_assert(std::is_unsigned<T>::value, "packed_vector require unsigned integer");
+
+public:
+  // stl container definition
+  typedef T value_type;
+  typedef std::size_t size_type;
+
+public:
+  /**
+   * @brief construct, width grow with pushed value
+   * */
+  packed_vector() {
+    words_.resize(1, 0);
+  }
+
+  /**
+   * @brief construct with fixed start width
+   * @param[in] width bit width
+   * */
+  explicit packed_vector(unsigned width) : width_(width) {
+    if (width > sizeof(T) * 8)
+      throw std::length_error("packed_vector width");
+    words_.resize(1, 0);
+  }
+
+public:
+  /**
+   * @brief get index element
+   * @param[in] index element index
+   * */
+  T operator[] (size_type index) const {
+    return T(_bit_pack::read(words_.data(), index * width_, width_));
+  }
+
+  /**
+   * @brief get index element with range check
+   * @param[in] index element index
+   * */
+  T at(size_type index) const {
+    if (index >= size_)
+      throw std::out_of_range("packed_vector index");
+    return (*this)[index];
+  }
+
+  /**
+   * @brief set index element, widen all elements if value not fit
+   * @param[in] index element index
+   * @param[in] value element value
+   * */
+  void set(size_type index, T value) {
+    widen(_bit_pack::bit_width(value));
+    _bit_pack::write(words_.data(), index * width_, value, width_);
+  }
+
+  /**
+   * @brief push value to back
+   * @param[in] value back value
+   * */
+  void push_back(T value) {
+    widen(_bit_pack::bit_width(value));
+    ensure_words(size_ + 1);
+    _bit_pack::write(words_.data(), size_ * width_, value, width_);
+    size_++;
+  }
+
+  /**
+   * @brief append values, width is widened once for all values
+   * @param[in] values value array
+   * @param[in] count value count
+   * */
+  void append(const T* values, size_type count) {
+    T max_value = 0;
+    for (size_type index = 0; index < count; index++)
+      max_value |= values[index];
+    widen(_bit_pack::bit_width(max_value));
+    ensure_words(size_ + count);
+    std::uint64_t* words = words_.data();
+    for (size_type index = 0; index < count; index++)
+      _bit_pack::write(words, (size_ + index) * width_, values[index], width_);
+    size_ += count;
+  }
+
+  /**
+   * @brief replace content, width is the least to hold all values
+   * @param[in] values value array
+   * @param[in] count value count
+   * */
+  void build(const T* values, size_type count) {
+    clear();
+    width_ = 0;
+    append(values, count);
+  }
+
+  /**
+   * @brief decode continuous elements, aligned blocks of 64 use unrolled kernel
+   * @param[in] first first element index
+   * @param[in] count element count
+   * @param[out] out values
+   * */
+  void decode(size_type first, size_type count, T* out) const {
+    size_type index = first;
+    size_type last = first + count;
+    // head before block boundary
+    for (; index < last && (index & 63) != 0; index++)
+      *out++ = (*this)[index];
+    _bit_pack::unpack_func unpack = _bit_pack::unpacker(width_);
+    std::uint64_t buffer[64];
+    for (; index + 64 <= last; index += 64) {
+      unpack(words_.data() + (index >> 6) * width_, buffer);
+      for (unsigned offset = 0; offset < 64; offset++)
+        *out++ = T(buffer[offset]);
+    }
+    // tail
+    for (; index < last; index++)
+      *out++ = (*this)[index];
+  }
+
+  template<typename Func>
+  /**
+   * @brief call func with every element in order
+   * @param[in] func func(T)
+   * */
+  void for_each(Func func) const {
+    T buffer[64];
+    for (size_type index = 0; index < size_; index += 64) {
+      size_type count = size_ - index < 64 ? size_ - index : 64;
+      decode(index, count, buffer);
+      for (size_type offset = 0; offset < count; offset++)
+        func(buffer[offset]);
+    }
+  }
+
+public:
+  /**
+   * @brief element count
+   * */
+  size_type size() const {
+    return size_;
+  }
+
+  /**
+   * @brief check if empty
+   * */
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  /**
+   * @brief bit width of every element
+   * */
+  unsigned width() const {
+    return width_;
+  }
+
+  /**
+   * @brief storage bytes
+   * */
+  size_type memory_bytes() const {
+    return words_.size() * sizeof(std::uint64_t);
+  }
+
+  /**
+   * @brief reserve storage of count elements at current width
+   * @param[in] count element count
+   * */
+  void reserve(size_type count) {
+    words_.reserve(_bit_pack::word_count(count, width_) + 1);
+  }
+
+  /**
+   * @brief remove all elements, width is kept
+   * */
+  void clear() {
+    size_ = 0;
+    words_.resize(1);
+    words_[0] = 0;
+  }
+
+private:
+  /**
+   * @brief make words hold count elements, one more word for read
+   * @param[in] count element count
+   * */
+  void ensure_words(size_type count) {
+    size_type need = _bit_pack::word_count(count, width_) + 1;
+    if (need > words_.size())
+      words_.resize(need, 0);
+  }
+
+  /**
+   * @brief repack all elements if width is not enough
+   * @param[in] width required width
+   * */
+  void widen(unsigned width) {
+    if (width <= width_)
+      return;
+    vector<std::uint64_t, Alloc> words(_bit_pack::word_count(size_, width) + 1, 0);
+    for (size_type index = 0; index < size_; index++)
+      _bit_pack::write(words.data(), index * width, (*this)[index], width);
+    words_.swap(words);
+    width_ = width;
+  }
+
+private:
+  /// packed words, at least one word
+  vector<std::uint64_t, Alloc> words_;
+  /// element count
+  size_type size_ { 0 };
+  /// bit width of every element
+  unsigned width_ { 0 };
+};
+
+// delta_vector, frame of reference encoding, every block of 128 values
+// store delta to the block minimum with the block own width,
+// sorted or clustered ids need only a few bits per value
+template<typename T = std::uint64_t, typename Alloc = alloc>
+class delta_vector {
+  static_assert(std::is_unsigned<T>::value, "delta_vector require unsigned integer");
+
+public:
+  // stl container definition
+  typedef T value_type;
+  typedef std::size_t size_type;
+
+  /// values per block
+  static const size_type block_size = 128;
+
+public:
+  /**
+   * @brief construct
+   * */
+  delta_vector() {
+    words_.resize(1, 0);
+  }
+
+public:
+  /**
+   * @brief get index element
+   * @param[in] index element index
+   * */
+  T operator[] (size_type index) const {
+    size_type block = index / block_size;
+    size_type offset = index % block_size;
+    if (block == blocks_.size())
+      return tail_[offset];
+    const block_header& header = blocks_[block];
+    return T(header.base + _bit_pack::read(words_.data() + header.word,
+                                           offset * header.width, header.width));
+  }
+
+  /**
+   * @brief get index element with range check
+   * @param[in] index element index
+   * */
+  T at(size_type index) const {
+    if (index >= size())
+      throw std::out_of_range("delta_vector index");
+    return (*this)[index];
+  }
+
+  /**
+   * @brief push value to back, block is encoded once it is full
+   * @param[in] value back value
+   * */
+  void push_back(T value) {
+    tail_[tail_count_++] = value;
+    if (tail_count_ == block_size)
+      seal();
+  }
+
+  /**
+   * @brief append values
+   * @param[in] values value array
+   * @param[in] count value count
+   * */
+  void append(const T* values, size_type count) {
+    while (count > 0) {
+      size_type step = block_size - tail_count_;
+      if (step > count)
+        step = count;
+      for (size_type index = 0; index < step; index++)
+        tail_[tail_count_ + index] = values[index];
+      tail_count_ += step;
+      values += step;
+      count -= step;
+      if (tail_count_ == block_size)
+        seal();
+    }
+  }
+
+  /**
+   * @brief replace content
+   * @param[in] values value array
+   * @param[in] count value count
+   * */
+  void build(const T* values, size_type count) {
+    clear();
+    blocks_.reserve(count / block_size);
+    append(values, count);
+  }
+
+  /**
+   * @brief decode one block
+   * @param[in] block block index, tail block included
+   * @param[out] out values, at least block_size
+   * @return value count of block
+   * */
+  size_type decode_block(size_type block, T* out) const {
+    if (block == blocks_.size()) {
+      for (size_type index = 0; index < tail_count_; index++)
+        out[index] = tail_[index];
+      return tail_count_;
+    }
+    const block_header& header = blocks_[block];
+    _bit_pack::unpack_func unpack = _bit_pack::unpacker(header.width);
+    std::uint64_t buffer[block_size];
+    unpack(words_.data() + header.word, buffer);
+    unpack(words_.data() + header.word + header.width, buffer + 64);
+    // add base, vectorizable
+    for (size_type index = 0; index < block_size; index++)
+      out[index] = T(buffer[index] + header.base);
+    return block_size;
+  }
+
+  template<typename Func>
+  /**
+   * @brief call func with every element in order
+   * @param[in] func func(T)
+   * */
+  void for_each(Func func) const {
+    T buffer[block_size];
+    for (size_type block = 0; block <= blocks_.size(); block++) {
+      size_type count = decode_block(block, buffer);
+      for (size_type index = 0; index < count; index++)
+        func(buffer[index]);
+    }
+  }
+
+public:
+  /**
+   * @brief element count
+   * */
+  size_type size() const {
+    return blocks_.size() * block_size + tail_count_;
+  }
+
+  /**
+   * @brief check if empty
+   * */
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /**
+   * @brief block count, tail block excluded
+   * */
+  size_type block_count() const {
+    return blocks_.size();
+  }
+
+  /**
+   * @brief storage bytes
+   * */
+  size_type memory_bytes() const {
+    return words_.size() * sizeof(std::uint64_t) + blocks_.size() * sizeof(block_header) +
+           sizeof(tail_);
+  }
+
+  /**
+   * @brief remove all elements
+   * */
+  void clear() {
+    blocks_.clear();
+    words_.resize(1);
+    words_[0] = 0;
+    tail_count_ = 0;
+  }
+
+private:
+  /**
+   * @brief encode full tail block
+   * */
+  void seal() {
+    T min_value = tail_[0];
+    T max_value = tail_[0];
+    for (size_type index = 1; index < block_size; index++) {
+      min_value = tail_[index] < min_value ? tail_[index] : min_value;
+      max_value = tail_[index] > max_value ? tail_[index] : max_value;
+    }
+    unsigned width = _bit_pack::bit_width(std::uint64_t(max_value - min_value));
+    // last word is read padding, block start from it
+    size_type word = words_.size() - 1;
+    words_.resize(word + 2 * width + 1, 0);
+    std::uint64_t* words = words_.data() + word;
+    for (size_type index = 0; index < block_size; index++)
+      _bit_pack::write(words, index * width, tail_[index] - min_value, width);
+    block_header header;
+    header.base = min_value;
+    header.word = word;
+    header.width = width;
+    blocks_.push_back(header);
+    tail_count_ = 0;
+  }
+
+private:
+  // encoded block
+  struct block_header {
+    /// block minimum
+    std::uint64_t base;
+    /// first word of block
+    std::uint64_t word : 56;
+    /// delta bit width
+    std::uint64_t width : 8;
+  };
+
+  /// encoded blocks
+  vector<block_header, Alloc> blocks_;
+  /// packed deltas, at least one word
+  vector<std::uint64_t, Alloc> words_;
+  /// values not encoded yet
+  T tail_[block_size];
+  /// tail value count
+  size_type tail_count_ { 0 };
+};
+
+}
+
+#endif // !__STL_PACKED_VECTOR_H__
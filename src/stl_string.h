@@ -0,0 +1,773 @@
+#ifndef __STL_STRING_H__
+#define __STL_STRING_H__
+
+#include "stl_alloc.h"
+#include "stl_uninitialized.h"
+
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <utility>
+#include <ostream>
+#include <stdexcept>
+#include <functional>
+#include <string_view>
+
+namespace stl {
+
+// basic_string, short string is stored inline (23 chars for char),
+// longer string is allocated from Alloc, so medium strings reach pool free lists
+template<typename CharT, typename Alloc = alloc>
+class basic_string {
+public:
+  // stl container definition
+  typedef CharT value_type;
+  typedef CharT* pointer;
+  typedef CharT* iterator;
+  typedef const CharT* const_iterator;
+  typedef CharT& reference;
+  typedef const CharT& const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef std::char_traits<CharT> traits_type;
+  typedef std::basic_string_view<CharT> view_type;
+
+  /// not found pos
+  static const size_type npos = size_type(-1);
+  /// inline bytes, terminator included
+  static const size_type local_bytes = 24;
+  /// chars stored inline, terminator excluded
+  static const size_type local_capacity = local_bytes / sizeof(CharT) - 1;
+
+protected:
+  typedef simple_alloc<CharT, Alloc> data_allocator;
+
+public:
+  /**
+   * @brief construct empty string
+   * */
+  basic_string() {
+    local_[0] = CharT();
+  }
+
+  /**
+   * @brief construct from c string
+   * @param[in] str c string
+   * */
+  basic_string(const CharT* str) : basic_string() {
+    append(str, traits_type::length(str));
+  }
+
+  /**
+   * @brief construct from chars
+   * @param[in] str chars
+   * @param[in] count char count
+   * */
+  basic_string(const CharT* str, size_type count) : basic_string() {
+    append(str, count);
+  }
+
+  /**
+   * @brief construct with count same chars
+   * @param[in] count char count
+   * @param[in] ch char
+   * */
+  basic_string(size_type count, CharT ch) : basic_string() {
+    append(count, ch);
+  }
+
+  /**
+   * @brief construct from string view
+   * @param[in] view string view
+   * */
+  explicit basic_string(view_type view) : basic_string() {
+    append(view.data(), view.size());
+  }
+
+  /**
+   * @brief copy construct
+   * @param[in] other other string
+   * */
+  basic_string(const basic_string& other) : basic_string() {
+    append(other.data(), other.size());
+  }
+
+  /**
+   * @brief move construct, take heap storage of other
+   * @param[in] other other string
+   * */
+  basic_string(basic_string&& other) noexcept {
+    take(other);
+  }
+
+  /**
+   * @brief release heap storage
+   * */
+  ~basic_string() {
+    release();
+  }
+
+  /**
+   * @brief copy assign, reuse storage when possible
+   * @param[in] other other string
+   * */
+  basic_string& operator=(const basic_string& other) {
+    return assign(other.data(), other.size());
+  }
+
+  /**
+   * @brief move assign
+   * @param[in] other other string
+   * */
+  basic_string& operator=(basic_string&& other) noexcept {
+    if (this != &other) {
+      release();
+      take(other);
+    }
+    return *this;
+  }
+
+  /**
+   * @brief assign c string
+   * @param[in] str c string
+   * */
+  basic_string& operator=(const CharT* str) {
+    return assign(str, traits_type::length(str));
+  }
+
+  /**
+   * @brief assign chars, reuse storage when possible
+   * @param[in] str chars, may point into this string
+   * @param[in] count char count
+   * */
+  basic_string& assign(const CharT* str, size_type count) {
+    if (count <= capacity()) {
+      traits_type::move(ptr(), str, count);
+      set_size(count);
+      return *this;
+    }
+    // str is still valid until old storage is released
+    basic_string tmp;
+    tmp.reserve(count);
+    tmp.append(str, count);
+    swap(tmp);
+    return *this;
+  }
+
+public:
+  /**
+   * @brief get begin iterator
+   * */
+  iterator begin() {
+    return ptr();
+  }
+
+  /**
+   * @brief get end iterator
+   * */
+  iterator end() {
+    return ptr() + size();
+  }
+
+  /**
+   * @brief get const begin iterator
+   * */
+  const_iterator begin() const {
+    return ptr();
+  }
+
+  /**
+   * @brief get const end iterator
+   * */
+  const_iterator end() const {
+    return ptr() + size();
+  }
+
+  /**
+   * @brief get char
+   * @param[in] index char index
+   * */
+  reference operator[] (size_type index) {
+    return ptr()[index];
+  }
+
+  /**
+   * @brief get const char
+   * @param[in] index char index
+   * */
+  const_reference operator[] (size_type index) const {
+    return ptr()[index];
+  }
+
+  /**
+   * @brief get char with range check
+   * @param[in] index char index
+   * */
+  reference at(size_type index) {
+    if (index >= size())
+      throw std::out_of_range("string index");
+    return ptr()[index];
+  }
+
+  /**
+   * @brief get const char with range check
+   * @param[in] index char index
+   * */
+  const_reference at(size_type index) const {
+    if (index >= size())
+      throw std::out_of_range("string index");
+    return ptr()[index];
+  }
+
+  /**
+   * @brief get first char
+   * */
+  reference front() {
+    return ptr()[0];
+  }
+
+  /**
+   * @brief get last char
+   * */
+  reference back() {
+    return ptr()[size() - 1];
+  }
+
+  /**
+   * @brief get chars, null terminated
+   * */
+  const CharT* data() const {
+    return ptr();
+  }
+
+  /**
+   * @brief get writable chars
+   * */
+  CharT* data() {
+    return ptr();
+  }
+
+  /**
+   * @brief get c string
+   * */
+  const CharT* c_str() const {
+    return ptr();
+  }
+
+  /**
+   * @brief get string view
+   * */
+  view_type view() const {
+    return view_type(ptr(), size());
+  }
+
+  /**
+   * @brief convert to string view
+   * */
+  operator view_type() const {
+    return view();
+  }
+
+  /**
+   * @brief convert to std string
+   * */
+  std::basic_string<CharT> str() const {
+    return std::basic_string<CharT>(ptr(), size());
+  }
+
+public:
+  /**
+   * @brief char count
+   * */
+  size_type size() const {
+    return size_ >> 1;
+  }
+
+  /**
+   * @brief char count
+   * */
+  size_type length() const {
+    return size();
+  }
+
+  /**
+   * @brief check if empty
+   * */
+  bool empty() const {
+    return size() == 0;
+  }
+
+  /**
+   * @brief chars can be held without allocation, terminator excluded
+   * */
+  size_type capacity() const {
+    return is_heap() ? heap_.capacity : local_capacity;
+  }
+
+  /**
+   * @brief max char count
+   * */
+  size_type max_size() const {
+    return (size_type(-1) >> 1) / sizeof(CharT) - 1;
+  }
+
+  /**
+   * @brief reserve storage of count chars
+   * @param[in] count char count
+   * */
+  void reserve(size_type count) {
+    if (count > capacity())
+      reallocate(count);
+  }
+
+  /**
+   * @brief move heap string back to inline storage or release spare storage
+   * */
+  void shrink_to_fit() {
+    if (!is_heap() || heap_.capacity == round_capacity(size()))
+      return;
+    basic_string tmp(ptr(), size());
+    swap(tmp);
+  }
+
+public:
+  /**
+   * @brief remove all chars, storage is kept
+   * */
+  void clear() {
+    set_size(0);
+  }
+
+  /**
+   * @brief resize, new chars are ch
+   * @param[in] count char count
+   * @param[in] ch new char
+   * */
+  void resize(size_type count, CharT ch = CharT()) {
+    size_type old_size = size();
+    if (count > old_size) {
+      append(count - old_size, ch);
+      return;
+    }
+    set_size(count);
+  }
+
+  /**
+   * @brief resize, new chars are left uninitialized
+   *        use it when chars will be overwritten at once, e.g. read() target
+   * @param[in] count char count
+   * */
+  void resize_default_init(size_type count) {
+    set_size(grow_to(count), count);
+  }
+
+  /**
+   * @brief append chars
+   * @param[in] str chars, may point into this string
+   * @param[in] count char count
+   * */
+  basic_string& append(const CharT* str, size_type count) {
+    size_type old_size = size();
+    if (old_size + count > capacity()) {
+      // str may point into old storage
+      difference_type offset = str - ptr();
+      bool inside = offset >= 0 && size_type(offset) < old_size;
+      CharT* data = grow_to(old_size + count);
+      if (inside)
+        str = data + offset;
+    }
+    CharT* data = ptr();
+    stl::uninitialized_copy(str, str + count, data + old_size);
+    set_size(data, old_size + count);
+    return *this;
+  }
+
+  /**
+   * @brief append c string
+   * @param[in] str c string
+   * */
+  basic_string& append(const CharT* str) {
+    return append(str, traits_type::length(str));
+  }
+
+  /**
+   * @brief append other string
+   * @param[in] other other string
+   * */
+  basic_string& append(const basic_string& other) {
+    return append(other.data(), other.size());
+  }
+
+  /**
+   * @brief append string view
+   * @param[in] view string view
+   * */
+  basic_string& append(view_type view) {
+    return append(view.data(), view.size());
+  }
+
+  /**
+   * @brief append count same chars
+   * @param[in] count char count
+   * @param[in] ch char
+   * */
+  basic_string& append(size_type count, CharT ch) {
+    size_type old_size = size();
+    CharT* data = grow_to(old_size + count);
+    stl::uninitialized_fill_n(data + old_size, count, ch);
+    set_size(data, old_size + count);
+    return *this;
+  }
+
+  /**
+   * @brief append char
+   * @param[in] ch char
+   * */
+  void push_back(CharT ch) {
+    size_type old_size = size();
+    CharT* data = grow_to(old_size + 1);
+    data[old_size] = ch;
+    set_size(data, old_size + 1);
+  }
+
+  /**
+   * @brief remove last char
+   * */
+  void pop_back() {
+    set_size(size() - 1);
+  }
+
+  /**
+   * @brief append other string
+   * @param[in] other other string
+   * */
+  basic_string& operator+=(const basic_string& other) {
+    return append(other.data(), other.size());
+  }
+
+  /**
+   * @brief append c string
+   * @param[in] str c string
+   * */
+  basic_string& operator+=(const CharT* str) {
+    return append(str);
+  }
+
+  /**
+   * @brief append char
+   * @param[in] ch char
+   * */
+  basic_string& operator+=(CharT ch) {
+    push_back(ch);
+    return *this;
+  }
+
+  /**
+   * @brief erase chars
+   * @param[in] pos first char pos
+   * @param[in] count char count
+   * */
+  basic_string& erase(size_type pos, size_type count = npos) {
+    size_type old_size = size();
+    if (pos > old_size)
+      throw std::out_of_range("string erase pos");
+    if (count > old_size - pos)
+      count = old_size - pos;
+    traits_type::move(ptr() + pos, ptr() + pos + count, old_size - pos - count);
+    set_size(old_size - count);
+    return *this;
+  }
+
+  /**
+   * @brief swap with other string, inline chars are swapped by bytes
+   * @param[in] other other string
+   * */
+  void swap(basic_string& other) noexcept {
+    char tmp[local_bytes];
+    std::memcpy(tmp, storage_, local_bytes);
+    std::memcpy(storage_, other.storage_, local_bytes);
+    std::memcpy(other.storage_, tmp, local_bytes);
+    std::swap(size_, other.size_);
+  }
+
+public:
+  /**
+   * @brief find chars
+   * @param[in] view chars to find
+   * @param[in] pos search start pos
+   * @return pos, npos if not found
+   * */
+  size_type find(view_type view, size_type pos = 0) const {
+    return this->view().find(view, pos);
+  }
+
+  /**
+   * @brief find char
+   * @param[in] ch char to find
+   * @param[in] pos search start pos
+   * @return pos, npos if not found
+   * */
+  size_type find(CharT ch, size_type pos = 0) const {
+    return view().find(ch, pos);
+  }
+
+  /**
+   * @brief get sub string
+   * @param[in] pos first char pos
+   * @param[in] count char count
+   * */
+  basic_string substr(size_type pos = 0, size_type count = npos) const {
+    return basic_string(view().substr(pos, count));
+  }
+
+  /**
+   * @brief compare with other chars
+   * @param[in] view other chars
+   * */
+  int compare(view_type view) const {
+    return this->view().compare(view);
+  }
+
+private:
+  // heap storage
+  struct heap_data {
+    /// chars
+    CharT* ptr;
+    /// chars can be held, terminator excluded
+    size_type capacity;
+  };
+
+  /**
+   * @brief check if chars are on heap
+   * */
+  bool is_heap() const {
+    return size_ & 1;
+  }
+
+  /**
+   * @brief current chars
+   * */
+  CharT* ptr() {
+    return is_heap() ? heap_.ptr : local_;
+  }
+
+  /**
+   * @brief current const chars
+   * */
+  const CharT* ptr() const {
+    return is_heap() ? heap_.ptr : local_;
+  }
+
+  /**
+   * @brief set size and terminator
+   * @param[in] count char count
+   * */
+  void set_size(size_type count) {
+    set_size(ptr(), count);
+  }
+
+  /**
+   * @brief set size and terminator
+   * @param[in] data current chars
+   * @param[in] count char count
+   * */
+  void set_size(CharT* data, size_type count) {
+    // terminator first, char store may alias size_
+    data[count] = CharT();
+    size_ = (count << 1) | (size_ & 1);
+  }
+
+  /**
+   * @brief round capacity up so allocation fill whole pool block
+   * @param[in] count char count, terminator excluded
+   * */
+  static size_type round_capacity(size_type count) {
+    size_type align = Alloc::align_size;
+    size_type bytes = ((count + 1) * sizeof(CharT) + align - 1) & ~(align - 1);
+    return bytes / sizeof(CharT) - 1;
+  }
+
+  /**
+   * @brief make capacity hold count chars, grow geometrically
+   * @param[in] count char count
+   * @return current chars
+   * */
+  CharT* grow_to(size_type count) {
+    size_type old_capacity = capacity();
+    if (count <= old_capacity)
+      return ptr();
+    if (count > max_size())
+      throw std::length_error("string too long");
+    return reallocate(count < 2 * old_capacity ? 2 * old_capacity : count);
+  }
+
+  /**
+   * @brief move chars to new heap storage
+   * @param[in] count char count can be held at least
+   * @return new chars
+   * */
+  CharT* reallocate(size_type count) {
+    size_type new_capacity = round_capacity(count);
+    CharT* new_ptr = data_allocator::allocate(new_capacity + 1);
+    size_type old_size = size();
+    stl::uninitialized_copy(ptr(), ptr() + old_size + 1, new_ptr);
+    release();
+    heap_.ptr = new_ptr;
+    heap_.capacity = new_capacity;
+    size_ = (old_size << 1) | 1;
+    return new_ptr;
+  }
+
+  /**
+   * @brief release heap storage
+   * */
+  void release() {
+    if (is_heap())
+      data_allocator::deallocate(heap_.ptr, heap_.capacity + 1);
+  }
+
+  /**
+   * @brief take storage of other, other become empty
+   * @param[in] other other string
+   * */
+  void take(basic_string& other) {
+    std::memcpy((void*)&storage_, &other.storage_, sizeof(storage_));
+    size_ = other.size_;
+    other.size_ = 0;
+    other.local_[0] = CharT();
+  }
+
+private:
+  union {
+    /// heap storage
+    heap_data heap_;
+    /// inline chars
+    CharT local_[local_bytes / sizeof(CharT)];
+    /// raw storage
+    char storage_[local_bytes];
+  };
+  /// char count << 1 | heap flag
+  size_type size_ { 0 };
+};
+
+/// init npos
+template<typename CharT, typename Alloc>
+const typename basic_string<CharT, Alloc>::size_type basic_string<CharT, Alloc>::npos;
+
+/// init local_bytes
+template<typename CharT, typename Alloc>
+const typename basic_string<CharT, Alloc>::size_type basic_string<CharT, Alloc>::local_bytes;
+
+/// init local_capacity
+template<typename CharT, typename Alloc>
+const typename basic_string<CharT, Alloc>::size_type basic_string<CharT, Alloc>::local_capacity;
+
+typedef basic_string<char> string;
+
+/**
+ * @brief concat two strings
+ * @param[in] left left string
+ * @param[in] right right string
+ * */
+template<typename CharT, typename Alloc>
+inline basic_string<CharT, Alloc> operator+(const basic_string<CharT, Alloc>& left,
+                                            const basic_string<CharT, Alloc>& right) {
+  basic_string<CharT, Alloc> result;
+  result.reserve(left.size() + right.size());
+  result.append(left);
+  result.append(right);
+  return result;
+}
+
+/**
+ * @brief concat string and c string
+ * @param[in] left left string
+ * @param[in] right right c string
+ * */
+template<typename CharT, typename Alloc>
+inline basic_string<CharT, Alloc> operator+(const basic_string<CharT, Alloc>& left,
+                                            const CharT* right) {
+  basic_string<CharT, Alloc> result(left);
+  result.append(right);
+  return result;
+}
+
+/**
+ * @brief check if two strings equal
+ * @param[in] left left string
+ * @param[in] right right string
+ * */
+template<typename CharT, typename Alloc>
+inline bool operator==(const basic_string<CharT, Alloc>& left,
+                       const basic_string<CharT, Alloc>& right) {
+  return left.view() == right.view();
+}
+
+/**
+ * @brief check if string equal to c string
+ * @param[in] left left string
+ * @param[in] right right c string
+ * */
+template<typename CharT, typename Alloc>
+inline bool operator==(const basic_string<CharT, Alloc>& left, const CharT* right) {
+  return left.view() == std::basic_string_view<CharT>(right);
+}
+
+/**
+ * @brief check if two strings differ
+ * @param[in] left left string
+ * @param[in] right right string
+ * */
+template<typename CharT, typename Alloc>
+inline bool operator!=(const basic_string<CharT, Alloc>& left,
+                       const basic_string<CharT, Alloc>& right) {
+  return !(left == right);
+}
+
+/**
+ * @brief check if string differ from c string
+ * @param[in] left left string
+ * @param[in] right right c string
+ * */
+template<typename CharT, typename Alloc>
+inline bool operator!=(const basic_string<CharT, Alloc>& left, const CharT* right) {
+  return !(left == right);
+}
+
+/**
+ * @brief compare two strings
+ * @param[in] left left string
+ * @param[in] right right string
+ * */
+template<typename CharT, typename Alloc>
+inline bool operator<(const basic_string<CharT, Alloc>& left,
+                      const basic_string<CharT, Alloc>& right) {
+  return left.view() < right.view();
+}
+
+/**
+ * @brief write string to stream
+ * @param[in] out stream
+ * @param[in] str string
+ * */
+template<typename CharT, typename Alloc>
+inline std::basic_ostream<CharT>& operator<<(std::basic_ostream<CharT>& out,
+                                             const basic_string<CharT, Alloc>& str) {
+  return out << str.view();
+}
+
+}
+
+namespace std {
+
+// hash same as std string
+template<typename CharT, typename Alloc>
+struct hash<stl::basic_string<CharT, Alloc>> {
+  size_t operator()(const stl::basic_string<CharT, Alloc>& str) const {
+    return hash<basic_string_view<CharT>>()(str.view());
+  }
+};
+
+}
+
+#endif // !__STL_STRING_H__
@@ -4,18 +4,73 @@
 #include "stl_define.h"
 
 #include <cstddef>
+#include <iterator>
+#include <type_traits>
 
 namespace stl {
 
-// general iterator trait
+// reference of iterator, reference_type of stl iterator or reference of std one
+template<typename T, typename = void>
+struct _iterator_reference {
+  typedef typename T::reference type;
+};
+
+template<typename T>
+struct _iterator_reference<T, std::void_t<typename T::reference_type>> {
+  typedef typename T::reference_type type;
+};
+
+// pointer of iterator, pointer_type of stl iterator or pointer of std one
+template<typename T, typename = void>
+struct _iterator_pointer {
+  typedef typename T::pointer type;
+};
+
+template<typename T>
+struct _iterator_pointer<T, std::void_t<typename T::pointer_type>> {
+  typedef typename T::pointer_type type;
+};
+
+// map std iterator tag to stl tag, stl tag is kept
+template<typename Tag>
+struct _iterator_category {
+  typedef Tag type;
+};
+
+template<>
+struct _iterator_category<std::input_iterator_tag> {
+  typedef input_iterator_tag type;
+};
+
+template<>
+struct _iterator_category<std::output_iterator_tag> {
+  typedef output_iterator_tag type;
+};
+
+template<>
+struct _iterator_category<std::forward_iterator_tag> {
+  typedef forward_iterator_tag type;
+};
+
+template<>
+struct _iterator_category<std::bidirectional_iterator_tag> {
+  typedef bidirectional_iterator_tag type;
+};
+
+template<>
+struct _iterator_category<std::random_access_iterator_tag> {
+  typedef random_access_iterator_tag type;
+};
+
+// general iterator trait, std iterators are accepted too
 template<typename T>
 struct iterator_trait {
   // iterator trait order definition
   typedef typename T::value_type value_type;
-  typedef typename T::reference_type reference_type;
+  typedef typename _iterator_reference<T>::type reference_type;
   typedef typename T::difference_type difference_type;
-  typedef typename T::pointer_type pointer_type;
-  typedef typename T::iterator_category iterator_category;
+  typedef typename _iterator_pointer<T>::type pointer_type;
+  typedef typename _iterator_category<typename T::iterator_category>::type iterator_category;
 };
 
 // basic type template partional spec
@@ -31,6 +86,31 @@ struct iterator_trait<T*> {
 
 // TODO: const type value type iterator trait
 
+// type trait, tell construct and uninitialized which fast path is safe
+template<typename T>
+struct __type_traits {
+  // trivial default construct, construct can be skipped
+  typedef interal_const<bool, std::is_trivially_default_constructible<T>::value> 
+      has_trivial_default_constructor;
+  // trivial copy construct, copy can be memmove
+  typedef interal_const<bool, std::is_trivially_copy_constructible<T>::value &&
+                              std::is_trivially_copyable<T>::value> 
+      has_trivial_copy_constructor;
+  // trivial assignment, assign can be memmove
+  typedef interal_const<bool, std::is_trivially_copy_assignable<T>::value &&
+                              std::is_trivially_copyable<T>::value> 
+      has_trivial_assignment_operator;
+  // trivial destroy, destroy can be skipped
+  typedef interal_const<bool, std::is_trivially_destructible<T>::value> 
+      has_trivial_destructor;
+  // plain old data
+  typedef interal_const<bool, std::is_trivial<T>::value && std::is_standard_layout<T>::value> 
+      is_POD_type;
+  // one byte trivial type, fill can be memset with any value
+  typedef interal_const<bool, has_trivial_copy_constructor::v && sizeof(T) == 1> 
+      is_bitwise_fillable;
+};
+
 }
 
 #endif // !__STL_TRAIT_H__
@@ -1,40 +1,38 @@
 #ifndef __STL_UNINITIALIZED_H__
 #define __STL_UNINITIALIZED_H__
 
+#include "stl_trait.h"
 #include "stl_construct.h"
 
 #include <cstring>
 #include <cstddef>
 #include <algorithm>
-#include <type_traits>
 
 namespace stl {
 
 /**
- * @brief copy pod data to target place
+ * @brief copy trivial data to target place
  * @param[in] begin iterator begin
  * @param[in] end iterator end
  * @param[out] result iterator result
- * @param[in] true_type pod true
- * */ 
-template<typename InputIterator, typename ForwardIterator> 
+ * @param[in] true_type trivial copy
+ * */
+template<typename InputIterator, typename ForwardIterator>
 inline ForwardIterator _uninitialized_copy_aux(InputIterator begin, InputIterator end,
-                                               ForwardIterator result, std::true_type) {
-  // use memcpy directly
-  // TODO: should self-rels copy algorithm
-  std::copy(begin, end, result);
+                                               ForwardIterator result, __true_type) {
+  return std::copy(begin, end, result);
 }
 
 /**
- * @brief copy non pod data to target place
+ * @brief copy non trivial data to target place
  * @param[in] begin iterator begin
  * @param[in] end iterator end
  * @param[out] result iterator result
- * @param[in] false_type pod false
- * */ 
-template<typename InputIterator, typename ForwardIterator> 
+ * @param[in] false_type non trivial copy
+ * */
+template<typename InputIterator, typename ForwardIterator>
 inline ForwardIterator _uninitialized_copy_aux(InputIterator begin, InputIterator end,
-                                               ForwardIterator result, std::false_type) {
+                                               ForwardIterator result, __false_type) {
   ForwardIterator cur = result;
   // construct all obj
   for (; begin != end; begin++, cur++) {
@@ -44,7 +42,7 @@ inline ForwardIterator _uninitialized_copy_aux(InputIterator begin, InputIterato
 }
 
 /**
- * @brief copy non pod data to target place
+ * @brief copy data to target place
  * @param[in] begin iterator begin
  * @param[in] end iterator end
  * @param[out] result iterator result
@@ -52,47 +50,148 @@ inline ForwardIterator _uninitialized_copy_aux(InputIterator begin, InputIterato
  * */
 template<typename InputIterator, typename ForwardIterator, typename T>
 inline ForwardIterator _uninitialized_copy(InputIterator begin, InputIterator end,
-                                           ForwardIterator result, const T&) {
-  typedef typename std::is_pod<T>::type pod_type;
-  return _uninitialized_copy_aux(begin, end, result, pod_type());
+                                           ForwardIterator result, const T*) {
+  typedef typename __type_traits<T>::has_trivial_copy_constructor trivial_copy;
+  return _uninitialized_copy_aux(begin, end, result, trivial_copy());
 }
 
 /**
- * @brief copy non pod data to target place
+ * @brief copy data to target place
  * @param[in] begin iterator begin
  * @param[in] end iterator end
  * @param[out] result iterator result
  * */
-template<typename InputIterator, typename ForwardIterator> 
-inline ForwardIterator uninitialized_copy(InputIterator begin, InputIterator end, 
+template<typename InputIterator, typename ForwardIterator>
+inline ForwardIterator uninitialized_copy(InputIterator begin, InputIterator end,
                                   ForwardIterator result) {
-  typedef typename ForwardIterator::value_type value_type;
-  return _uninitialized_copy(begin, end, result, value_type());
+  typedef typename iterator_trait<ForwardIterator>::value_type value_type;
+  return _uninitialized_copy(begin, end, result, (value_type*)nullptr);
+}
+
+/**
+ * @brief copy trivial data between pointers, use memmove
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result
+ * @param[in] true_type trivial copy
+ * */
+template<typename T>
+inline T* _uninitialized_copy_ptr(const T* begin, const T* end, T* result, __true_type) {
+  std::size_t count = end - begin;
+  if (count > 0)
+    std::memmove((void*)result, (const void*)begin, count * sizeof(T));
+  return result + count;
+}
+
+/**
+ * @brief copy non trivial data between pointers
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result
+ * @param[in] false_type non trivial copy
+ * */
+template<typename T>
+inline T* _uninitialized_copy_ptr(const T* begin, const T* end, T* result, __false_type) {
+  return _uninitialized_copy_aux(begin, end, result, __false_type());
+}
+
+/**
+ * @brief copy specialization for pointer, every scalar type reach memmove
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result
+ * */
+template<typename T>
+inline T* uninitialized_copy(const T* begin, const T* end, T* result) {
+  typedef typename __type_traits<T>::has_trivial_copy_constructor trivial_copy;
+  return _uninitialized_copy_ptr(begin, end, result, trivial_copy());
+}
+
+/**
+ * @brief copy specialization for pointer, every scalar type reach memmove
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[out] result pointer result
+ * */
+template<typename T>
+inline T* uninitialized_copy(T* begin, T* end, T* result) {
+  return uninitialized_copy((const T*)begin, (const T*)end, result);
 }
 
 /**
- * @brief fill pod data to target place
+ * @brief check if value is all zero bytes, so it can be filled by memset
+ * @param[in] value obj value
+ * */
+template<typename T>
+inline bool _is_zero_bytes(const T& value) {
+  const unsigned char* bytes = (const unsigned char*)&value;
+  for (std::size_t index = 0; index < sizeof(T); index++) {
+    if (bytes[index] != 0)
+      return false;
+  }
+  return true;
+}
+
+/**
+ * @brief fill trivial data to pointer place
+ * @param[in] begin pointer begin
+ * @param[in] count fill count
+ * @param[in] value obj param
+ * @param[in] true_type trivial copy
+ * */
+template<typename T, typename U>
+inline void _uninitialized_fill_ptr(T* begin, std::size_t count, const U& value, __true_type) {
+  if (count == 0)
+    return;
+  T tmp(value);
+  typedef typename __type_traits<T>::is_bitwise_fillable bitwise_fillable;
+  // one byte type or zero value reach memset
+  if (bitwise_fillable::v || _is_zero_bytes(tmp)) {
+    unsigned char byte;
+    std::memcpy(&byte, &tmp, 1);
+    std::memset((void*)begin, byte, count * sizeof(T));
+    return;
+  }
+  std::fill_n(begin, count, tmp);
+}
+
+/**
+ * @brief fill non trivial data to pointer place
+ * @param[in] begin pointer begin
+ * @param[in] count fill count
+ * @param[in] value obj param
+ * @param[in] false_type non trivial copy
+ * */
+template<typename T, typename U>
+inline void _uninitialized_fill_ptr(T* begin, std::size_t count, const U& value, __false_type) {
+  for (; count > 0; count--, begin++) {
+    construct(begin, value);
+  }
+}
+
+/**
+ * @brief fill trivial data to target place
  * @param[in] begin iterator begin
  * @param[in] end iterator end
  * @param[in] value obj param
- * @param[in] true_type pod type
+ * @param[in] true_type trivial copy
  * */
 template<typename ForwardIterator, typename T>
 inline void _uninitialized_fill_aux(ForwardIterator begin, ForwardIterator end,
-                                const T& value, std::true_type) {
-  return std::fill(begin, end, value);
+                                const T& value, __true_type) {
+  std::fill(begin, end, value);
 }
 
 /**
- * @brief fill pod data to target place
+ * @brief fill non trivial data to target place
  * @param[in] begin iterator begin
  * @param[in] end iterator end
  * @param[in] value obj param
- * @param[in] false_type non-pod type
+ * @param[in] false_type non trivial copy
  * */
 template<typename ForwardIterator, typename T>
-inline void _uninitialized_fill_aux(ForwardIterator begin, ForwardIterator end, 
-                                    const T& value, std::false_type) {
+inline void _uninitialized_fill_aux(ForwardIterator begin, ForwardIterator end,
+                                    const T& value, __false_type) {
   ForwardIterator cur = begin;
   for (; cur != end; cur++) {
     construct(&(*cur), value);
@@ -100,54 +199,66 @@ inline void _uninitialized_fill_aux(ForwardIterator begin, ForwardIterator end,
 }
 
 /**
- * @brief fill pod data to target place
+ * @brief fill data to target place
  * @param[in] begin iterator begin
  * @param[in] end iterator end
  * @param[in] value obj param
- * @param[in] type iterator type
+ * @param[in] type iterator value type
  * */
 template<typename ForwardIterator, typename T, typename Type>
-inline void _uninitialized_fill(ForwardIterator begin, ForwardIterator end, const T& value, 
-                                const Type&) {
-  typedef typename std::is_pod<Type>::type pod_type;
-  return _uninitialized_fill_aux(begin, end, value, pod_type());
+inline void _uninitialized_fill(ForwardIterator begin, ForwardIterator end, const T& value,
+                                const Type*) {
+  typedef typename __type_traits<Type>::has_trivial_copy_constructor trivial_copy;
+  _uninitialized_fill_aux(begin, end, value, trivial_copy());
 }
 
 /**
- * @brief fill pod data to target place
+ * @brief fill data to target place
  * @param[in] begin iterator begin
  * @param[in] end iterator end
  * @param[in] value obj param
  * */
 template<typename ForwardIterator, typename T>
 inline void uninitialized_fill(ForwardIterator begin, ForwardIterator end, const T& value) {
-  typedef typename ForwardIterator::type value_type;
-  return _uninitialized_fill(begin, end, value, value_type());
+  typedef typename iterator_trait<ForwardIterator>::value_type value_type;
+  _uninitialized_fill(begin, end, value, (value_type*)nullptr);
 }
 
 /**
- * @brief fill pod data to target place 
+ * @brief fill specialization for pointer, trivial type reach memset when possible
+ * @param[in] begin pointer begin
+ * @param[in] end pointer end
+ * @param[in] value obj param
+ * */
+template<typename T, typename U>
+inline void uninitialized_fill(T* begin, T* end, const U& value) {
+  typedef typename __type_traits<T>::has_trivial_copy_constructor trivial_copy;
+  _uninitialized_fill_ptr(begin, end - begin, value, trivial_copy());
+}
+
+/**
+ * @brief fill trivial data to target place
  * @param[in] begin iterator begin
  * @param[in] count fill count
  * @param[in] value obj param
- * @param[in] true_type pod type
+ * @param[in] true_type trivial copy
  * */
 template<typename ForwardIterator, typename T>
-inline void _uninitialized_fill_n_aux(ForwardIterator begin, int count, const T& value,
-                                      std::true_type) {
-  return std::fill_n(begin, count, value);
+inline void _uninitialized_fill_n_aux(ForwardIterator begin, std::size_t count, const T& value,
+                                      __true_type) {
+  std::fill_n(begin, count, value);
 }
 
 /**
- * @brief fill pod data to target place 
+ * @brief fill non trivial data to target place
  * @param[in] begin iterator begin
  * @param[in] count fill count
  * @param[in] value obj param
- * @param[in] false_type pod type
+ * @param[in] false_type non trivial copy
  * */
 template<typename ForwardIterator, typename T>
-inline void _uninitialized_fill_n_aux(ForwardIterator begin, int count, const T& value,
-                                 std::false_type) {
+inline void _uninitialized_fill_n_aux(ForwardIterator begin, std::size_t count, const T& value,
+                                 __false_type) {
   ForwardIterator cur = begin;
   // use default construct
   for (; count > 0; count--, cur++) {
@@ -156,41 +267,41 @@ inline void _uninitialized_fill_n_aux(ForwardIterator begin, int count, const T&
 }
 
 /**
- * @brief fill pod data to target place 
+ * @brief fill data to target place
  * @param[in] begin iterator begin
  * @param[in] count fill count
  * @param[in] value obj param
- * @param[in] type obj type
+ * @param[in] type iterator value type
  * */
 template<typename ForwardIterator, typename T, typename Type>
-inline void _uninitialized_fill_n(ForwardIterator begin, int count, const T& value,
-                                 const Type&) {
-  typedef typename std::is_pod<Type>::type pod_type;
-  return _uninitialized_fill_n_aux(begin, count, value, pod_type());
+inline void _uninitialized_fill_n(ForwardIterator begin, std::size_t count, const T& value,
+                                 const Type*) {
+  typedef typename __type_traits<Type>::has_trivial_copy_constructor trivial_copy;
+  _uninitialized_fill_n_aux(begin, count, value, trivial_copy());
 }
 
 /**
- * @brief fill pod data to target place 
+ * @brief fill data to target place
  * @param[in] begin iterator begin
  * @param[in] count fill count
  * @param[in] value obj param
  * */
 template<typename ForwardIterator, typename T>
-inline void uninitialized_fill_n(ForwardIterator begin, int count, const T& value) {
-  typedef typename ForwardIterator::type value_type;
-  return _uninitialized_fill_n(begin, count, value, value_type());
+inline void uninitialized_fill_n(ForwardIterator begin, std::size_t count, const T& value) {
+  typedef typename iterator_trait<ForwardIterator>::value_type value_type;
+  _uninitialized_fill_n(begin, count, value, (value_type*)nullptr);
 }
 
 /**
- * @brief copy specialization
- * @param[in] begin iterator begin
- * @param[in] end iterator end
- * @param[in] result iterator result
+ * @brief fill specialization for pointer, trivial type reach memset when possible
+ * @param[in] begin pointer begin
+ * @param[in] count fill count
+ * @param[in] value obj param
  * */
-template<>
-inline char* uninitialized_copy(const char* begin, const char* end, char* result) {
-  memmove(result, begin, (end - begin));
-  return result + (end - begin);
+template<typename T, typename U>
+inline void uninitialized_fill_n(T* begin, std::size_t count, const U& value) {
+  typedef typename __type_traits<T>::has_trivial_copy_constructor trivial_copy;
+  _uninitialized_fill_ptr(begin, count, value, trivial_copy());
 }
 
 }
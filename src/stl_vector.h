@@ -2,18 +2,20 @@
 #define __STL_VECTOR_H__
 
 #include "stl_alloc.h"
+#include "stl_trait.h"
+#include "stl_algobase.h"
 #include "stl_construct.h"
 #include "stl_uninitialized.h"
+#include "stl_vector_stats.h"
 
 #include <new>
 #include <string>
 #include <cstddef>
+#include <utility>
 #include <stdexcept>
 
 namespace stl {
 
-typedef _default_alloc_template<true, 0> alloc;
-
 // vector 
 template<typename T, typename Alloc = alloc>
 class vector {
@@ -22,12 +24,94 @@ public:
   typedef T value_type;
   typedef T* pointer;
   typedef T* iterator;
+  typedef const T* const_iterator;
   typedef T& reference;
+  typedef const T& const_reference;
   typedef std::size_t size_type;
   typedef std::ptrdiff_t difference_type;
 
 protected:
-  typedef simple_alloc<T, alloc> data_allocator;
+  typedef simple_alloc<T, Alloc> data_allocator;
+
+public:
+  /**
+   * @brief construct empty vector
+   * */
+  vector() {}
+
+  /**
+   * @brief construct count elements with value
+   * @param[in] count elem count
+   * @param[in] value elem value
+   * */
+  vector(size_type count, const T& value) {
+    fill_initialize(count, value);
+  }
+
+  /**
+   * @brief construct count value initialized elements
+   * @param[in] count elem count
+   * */
+  explicit vector(size_type count) {
+    fill_initialize(count, T());
+  }
+
+  /**
+   * @brief copy construct
+   * @param[in] other other vector
+   * */
+  vector(const vector& other) {
+    size_type count = other.size();
+    if (count == 0)
+      return;
+    start_ = data_allocator::allocate(count);
+    finish_ = stl::uninitialized_copy(other.start_, other.finish_, start_);
+    end_of_storage_ = finish_;
+    // copy count to the site of its source
+    __STL_VECTOR_STATS_HOOK(stats_.site = other.stats_.site);
+  }
+
+  /**
+   * @brief move construct, steal storage
+   * @param[in] other other vector
+   * */
+  vector(vector&& other) noexcept {
+    swap(other);
+  }
+
+  /**
+   * @brief copy assign
+   * @param[in] other other vector
+   * */
+  vector& operator=(const vector& other) {
+    if (this != &other) {
+      vector tmp(other);
+      // assigned vector keep its own site and peak, replaced storage is no instance
+      __STL_VECTOR_STATS_HOOK(stats_.on_size(size()));
+      __STL_VECTOR_STATS_HOOK(tmp.stats_ = stats_);
+      swap(tmp);
+      __STL_VECTOR_STATS_HOOK(tmp.stats_.discard());
+    }
+    return *this;
+  }
+
+  /**
+   * @brief move assign
+   * @param[in] other other vector
+   * */
+  vector& operator=(vector&& other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  /**
+   * @brief destroy all elements and release memory
+   * */
+  ~vector() {
+    __STL_VECTOR_STATS_HOOK(stats_.on_destroy(size(), end_of_storage_ - start_, sizeof(T)));
+    stl::destroy(start_, finish_);
+    deallocate();
+  }
 
 public:
   /**
@@ -39,6 +123,16 @@ public:
    * @brief get end iterator
    * */
   iterator end() { return finish_; }
+
+  /**
+   * @brief get const begin iterator
+   * */
+  const_iterator begin() const { return start_; }
+
+  /**
+   * @brief get const end iterator
+   * */
+  const_iterator end() const { return finish_; }
   
   // element access
 public:
@@ -62,6 +156,14 @@ public:
   reference operator[] (size_type index) {
     return *(start_ + index);
   }
+
+  /**
+   * @brief get index element
+   * @param[in] index element index
+   * */
+  const_reference operator[] (size_type index) const {
+    return *(start_ + index);
+  }
   
   /**
    * @brief get front element
@@ -81,39 +183,48 @@ public:
     return start_;
   }
 
+  const T* data() const {
+    return start_;
+  }
+
   // capacity 
 public:
   
   /**
    * @brief check if vec is empty
    * */
-  bool empty() {
+  bool empty() const {
     return start_ == finish_;
   }
   
   /**
    * @brief element count
    * */
-  size_type size() {
+  size_type size() const {
     return size_type(finish_ - start_);
   }
   
   /**
    * @brief get total max size 
    * */
-  size_type max_size() {
+  size_type max_size() const {
     return size_type(end_of_storage_ - start_);
   }
 
-  void reverse(size_type size) {
-
+  /**
+   * @brief make total storage hold at least size elements
+   * @param[in] size elem count
+   * */
+  void reserve(size_type size) {
+    if (size > size_type(end_of_storage_ - start_))
+      reallocate(size);
   }
 
   /**
-   * @brief get current avaible size
+   * @brief get element count the total storage can hold
    * */ 
-  size_type capacity() {
-    return end_of_storage_ - finish_;
+  size_type capacity() const {
+    return end_of_storage_ - start_;
   }
 
   void shrink_to_fit() {
@@ -122,8 +233,11 @@ public:
   
   // modifier
 public:
+  /**
+   * @brief destroy all elements, storage is kept
+   * */
   void clear() {
-
+    erase(start_, finish_);
   }
 
   
@@ -133,8 +247,10 @@ public:
    * @param[in] value insert value
    * */
   iterator insert(iterator pos, const T& value) {
+    // storage may be reallocated, keep offset
+    size_type offset = pos - start_;
     insert_aux(pos, value);
-    return pos;
+    return start_ + offset;
   }
 
   /**
@@ -149,7 +265,7 @@ public:
       return;
     }
     // realloc and place
-    insert_aux(end() + 1, value);
+    insert_aux(end(), value);
   }
   
   template<typename... Args>
@@ -157,8 +273,66 @@ public:
     
   }
 
+  /**
+   * @brief resize, new elements are value initialized
+   * @param[in] size elem count
+   * */
   void resize(size_type size) {
+    resize(size, T());
+  }
+
+  /**
+   * @brief resize, new elements are copy of value
+   * @param[in] size elem count
+   * @param[in] value elem value
+   * */
+  void resize(size_type size, const T& value) {
+    size_type old_size = this->size();
+    if (size <= old_size) {
+      __STL_VECTOR_STATS_HOOK(stats_.on_size(old_size));
+      iterator new_finish = start_ + size;
+      stl::destroy(new_finish, finish_);
+      finish_ = new_finish;
+      return;
+    }
+    if (size <= size_type(end_of_storage_ - start_)) {
+      stl::uninitialized_fill_n(finish_, size - old_size, value);
+      finish_ = start_ + size;
+      return;
+    }
+    // value may refer to element which is destroyed by reallocation
+    T value_copy = value;
+    grow_to(size);
+    stl::uninitialized_fill_n(finish_, size - old_size, value_copy);
+    finish_ = start_ + size;
+  }
+
+  /**
+   * @brief resize, new elements are left uninitialized
+   *        use it when elements will be overwritten at once, e.g. read() target
+   * @param[in] size elem count
+   * */
+  void resize_default_init(size_type size) {
+    static_assert(__type_traits<T>::has_trivial_default_constructor::v && 
+                  __type_traits<T>::has_trivial_destructor::v,
+                  "resize_default_init require trivial type");
+    grow_to(size);
+    finish_ = start_ + size;
+  }
 
+  /**
+   * @brief append count uninitialized elements to back
+   * @param[in] count elem count
+   * @return first appended element, count elements are writable from it
+   * */
+  iterator append_uninitialized(size_type count) {
+    static_assert(__type_traits<T>::has_trivial_default_constructor::v && 
+                  __type_traits<T>::has_trivial_destructor::v,
+                  "append_uninitialized require trivial type");
+    size_type old_size = size();
+    grow_to(old_size + count);
+    finish_ = start_ + old_size + count;
+    return start_ + old_size;
   }
   
   /**
@@ -168,9 +342,10 @@ public:
   iterator erase(iterator pos) {
     // check if current pos valid
     if (pos >= finish_)
-      return;
-    // copy next pos to finish
-    stl::uninitialized_copy(pos + 1, finish_, pos);
+      return finish_;
+    __STL_VECTOR_STATS_HOOK(stats_.on_size(size()));
+    // move next pos to finish forward, one memmove for trivial type
+    stl::move(pos + 1, finish_, pos);
     --finish_;
     destroy(finish_);
     return pos;
@@ -181,13 +356,46 @@ public:
    * @param[in] begin iterator begin
    * @param[in] end iterator end
    * */
-  void erase(iterator begin, iterator end) {
-    
+  iterator erase(iterator begin, iterator end) {
+    if (begin == end)
+      return begin;
+    __STL_VECTOR_STATS_HOOK(stats_.on_size(size()));
+    // move tail forward, then destroy moved out elements
+    iterator new_finish = stl::move(end, finish_, begin);
+    stl::destroy(new_finish, finish_);
+    finish_ = new_finish;
+    return begin;
   }
 
+  /**
+   * @brief remove back element
+   * */
   void pop_back() {
+    __STL_VECTOR_STATS_HOOK(stats_.on_size(size()));
+    --finish_;
+    destroy(finish_);
+  }
+
+  /**
+   * @brief swap storage with other
+   * @param[in] other other vector
+   * */
+  void swap(vector& other) noexcept {
+    std::swap(start_, other.start_);
+    std::swap(finish_, other.finish_);
+    std::swap(end_of_storage_, other.end_of_storage_);
+    __STL_VECTOR_STATS_HOOK(std::swap(stats_, other.stats_));
+  }
 
+#ifdef __STL_VECTOR_STATS
+  /**
+   * @brief count this vector to site, use __STL_VECTOR_TRACK instead
+   * @param[in] site counting site
+   * */
+  void track_stats(vector_stats_site* site) {
+    stats_.site = site;
   }
+#endif
 
 private:
   /**
@@ -207,9 +415,9 @@ private:
    * @param[in] count elem count
    * @param[in] value elem value
    * */
-  void allocate_and_fill(size_type count, const T& value) {
+  iterator allocate_and_fill(size_type count, const T& value) {
     // allocate memory
-    iterator result = data_allocator::allocate(count);
+    iterator result = count == 0 ? nullptr : data_allocator::allocate(count);
     stl::uninitialized_fill_n(result, count, value);
     return result;
   }
@@ -222,24 +430,36 @@ private:
   void insert_aux(iterator pos, const T& value) {
     // check if current storage not enough
     if (finish_ != end_of_storage_) {
-      stl::uninitialized_copy(pos, finish_, pos + 1);
-      *pos = value;
+      // value may refer to element which will be moved
+      T value_copy = value;
+      if (pos == finish_) {
+        construct(finish_, value_copy);
+        ++finish_;
+        return;
+      }
+      // move new back from old back, then shift the rest backward
+      new ((void*)finish_) T(std::move(*(finish_ - 1)));
       ++finish_;
+      __STL_VECTOR_STATS_HOOK(stats_.on_shift(finish_ - 1 - pos, sizeof(T)));
+      stl::move_backward(pos, finish_ - 2, finish_ - 1);
+      *pos = std::move(value_copy);
       return;
     }
     // none capacity is left, should realloc memory
     size_type old_size = size();
     size_type new_size = old_size == 0 ? 1 : old_size * 2;
     iterator new_start = data_allocator::allocate(new_size);
+    __STL_VECTOR_STATS_HOOK(stats_.on_reallocate(old_size, new_size, sizeof(T)));
     // copy start to pos value to new start
     iterator new_finish = stl::uninitialized_copy(start_, pos, new_start);    
-    construct(pos, value);
+    construct(new_finish, value);
     // add finish
     ++new_finish;
     // copy left part
     new_finish = stl::uninitialized_copy(pos, finish_, new_finish);
     // destroy old memory
     stl::destroy(start_, finish_); 
+    deallocate();
     start_ = new_start;
     finish_ = new_finish;
     end_of_storage_ = start_ + new_size;
@@ -249,6 +469,40 @@ private:
 
   }
 
+  /**
+   * @brief make storage hold at least size elements, grow at least twice
+   * @param[in] size elem count
+   * */
+  void grow_to(size_type size) {
+    size_type old_capacity = size_type(end_of_storage_ - start_);
+    if (size <= old_capacity)
+      return;
+    reallocate(size < 2 * old_capacity ? 2 * old_capacity : size);
+  }
+
+  /**
+   * @brief move elements to new storage
+   * @param[in] new_capacity new storage elem count
+   * */
+  void reallocate(size_type new_capacity) {
+    iterator new_start = data_allocator::allocate(new_capacity);
+    __STL_VECTOR_STATS_HOOK(stats_.on_reallocate(size(), new_capacity, sizeof(T)));
+    iterator new_finish = stl::uninitialized_copy(start_, finish_, new_start);
+    stl::destroy(start_, finish_);
+    deallocate();
+    start_ = new_start;
+    finish_ = new_finish;
+    end_of_storage_ = new_start + new_capacity;
+  }
+
+  /**
+   * @brief release storage
+   * */
+  void deallocate() {
+    if (start_ != nullptr)
+      data_allocator::deallocate(start_, end_of_storage_ - start_);
+  }
+
 private:
   /// start iterator
   iterator start_ { nullptr };
@@ -256,8 +510,16 @@ private:
   iterator finish_ { nullptr };
   /// end of storage, real cap
   iterator end_of_storage_ { nullptr };
+#ifdef __STL_VECTOR_STATS
+  /// regrowth counters, only in instrumented build
+  vector_stats_slot stats_;
+#endif
 };
 
+/// vector whose buffer is aligned to Align, e.g. cache line or simd width
+template<typename T, std::size_t Align = cache_line_size, typename Alloc = alloc>
+using aligned_vector = vector<T, aligned_alloc_adapter<Alloc, Align>>;
+
 
 
 }
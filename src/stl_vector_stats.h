@@ -0,0 +1,243 @@
+#ifndef __STL_VECTOR_STATS_H__
+#define __STL_VECTOR_STATS_H__
+
+#include <cstddef>
+
+#ifdef __STL_VECTOR_STATS
+#include <atomic>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#endif
+
+namespace stl {
+
+#ifdef __STL_VECTOR_STATS
+
+// regrowth counters of vectors tagged with one label or call site
+// sites are static, registered once and never removed, all counters are relaxed
+struct vector_stats_site {
+  /**
+   * @brief register site to process-wide list
+   * @param[in] label caller label, nullptr to use file and line
+   * @param[in] file tagging source file
+   * @param[in] line tagging source line
+   * */
+  vector_stats_site(const char* label, const char* file, int line);
+
+  /**
+   * @brief raise counter to value if larger
+   * @param[in] counter peak counter
+   * @param[in] value observed value
+   * */
+  static void raise(std::atomic<std::size_t>& counter, std::size_t value) {
+    std::size_t old = counter.load(std::memory_order_relaxed);
+    while (old < value && !counter.compare_exchange_weak(old, value, std::memory_order_relaxed)) {}
+  }
+
+  /// caller label, may be nullptr
+  const char* label;
+  /// tagging source file
+  const char* file;
+  /// tagging source line
+  int line;
+  /// next registered site
+  vector_stats_site* next { nullptr };
+  /// destroyed vectors which had storage
+  std::atomic<std::size_t> instances { 0 };
+  /// storage reallocations, from insert_aux, reserve and resize
+  std::atomic<std::size_t> reallocations { 0 };
+  /// bytes copied from old to new storage on reallocation
+  std::atomic<std::size_t> copied_bytes { 0 };
+  /// bytes shifted by insert in middle without reallocation
+  std::atomic<std::size_t> shifted_bytes { 0 };
+  /// largest storage of one vector, in bytes
+  std::atomic<std::size_t> peak_capacity_bytes { 0 };
+  /// largest element count of one vector
+  std::atomic<std::size_t> peak_size { 0 };
+  /// sum of peak element count of destroyed vectors
+  std::atomic<std::size_t> total_peak_size { 0 };
+  /// sum of final storage bytes of destroyed vectors
+  std::atomic<std::size_t> total_final_capacity_bytes { 0 };
+  /// sum of final used bytes of destroyed vectors
+  std::atomic<std::size_t> total_final_size_bytes { 0 };
+};
+
+template<int insl>
+class _vector_stats_template {
+public:
+  /**
+   * @brief add site to list, lock-free
+   * @param[in] site new site
+   * */
+  static void add(vector_stats_site* site) {
+    vector_stats_site* head = head_.load(std::memory_order_relaxed);
+    do {
+      site->next = head;
+    } while (!head_.compare_exchange_weak(head, site, std::memory_order_release,
+                                          std::memory_order_relaxed));
+  }
+
+  /**
+   * @brief site of vectors never tagged
+   * */
+  static vector_stats_site* untagged() {
+    static vector_stats_site site("<untagged>", "", 0);
+    return &site;
+  }
+
+  /**
+   * @brief visit every registered site
+   * @param[in] func called with const vector_stats_site&
+   * */
+  template<typename Func>
+  static void for_each(Func func) {
+    for (vector_stats_site* site = head_.load(std::memory_order_acquire); site != nullptr;
+         site = site->next)
+      func(*(const vector_stats_site*)site);
+  }
+
+  /**
+   * @brief print sites by copied bytes, most wasteful first
+   *        live vectors count reallocations, but final size and capacity only after destroy
+   * @param[in] file output file
+   * */
+  static void report(std::FILE* file = stderr) {
+    std::vector<const vector_stats_site*> sites;
+    for_each([&](const vector_stats_site& site) {
+      if (site.reallocations.load(std::memory_order_relaxed) != 0 ||
+          site.instances.load(std::memory_order_relaxed) != 0)
+        sites.push_back(&site);
+    });
+    std::sort(sites.begin(), sites.end(),
+              [](const vector_stats_site* a, const vector_stats_site* b) {
+                return a->copied_bytes.load(std::memory_order_relaxed) >
+                       b->copied_bytes.load(std::memory_order_relaxed);
+              });
+    // bytes for copied, shifted and capacity, element count for size
+    std::fprintf(file, "%-32s %10s %10s %14s %14s %12s %12s %10s %10s %6s\n", "site",
+                 "instances", "reallocs", "copied B", "shifted B", "peak cap B", "avg cap B",
+                 "peak size", "avg peak", "fill");
+    for (const vector_stats_site* site : sites) {
+      char name[256];
+      if (site->label != nullptr)
+        std::snprintf(name, sizeof(name), "%s", site->label);
+      else
+        std::snprintf(name, sizeof(name), "%s:%d", site->file, site->line);
+      std::size_t instances = site->instances.load(std::memory_order_relaxed);
+      std::size_t capacity = site->total_final_capacity_bytes.load(std::memory_order_relaxed);
+      std::size_t used = site->total_final_size_bytes.load(std::memory_order_relaxed);
+      std::size_t peak = site->total_peak_size.load(std::memory_order_relaxed);
+      std::fprintf(file, "%-32s %10zu %10zu %14zu %14zu %12zu %12zu %10zu %10zu %5.0f%%\n",
+                   name, instances, site->reallocations.load(std::memory_order_relaxed),
+                   site->copied_bytes.load(std::memory_order_relaxed),
+                   site->shifted_bytes.load(std::memory_order_relaxed),
+                   site->peak_capacity_bytes.load(std::memory_order_relaxed),
+                   instances == 0 ? 0 : capacity / instances,
+                   site->peak_size.load(std::memory_order_relaxed),
+                   instances == 0 ? 0 : peak / instances,
+                   capacity == 0 ? 100.0 : 100.0 * used / capacity);
+    }
+  }
+
+private:
+  /// registered sites, newest first
+  static std::atomic<vector_stats_site*> head_;
+};
+
+/// init site list
+template<int insl>
+std::atomic<vector_stats_site*> _vector_stats_template<insl>::head_ { nullptr };
+
+// redefine vector stats
+typedef _vector_stats_template<0> vector_stats;
+
+inline vector_stats_site::vector_stats_site(const char* label, const char* file, int line)
+  : label(label), file(file), line(line) {
+  vector_stats::add(this);
+}
+
+// per vector state, storage and its history move together on swap
+struct vector_stats_slot {
+  /**
+   * @brief storage is reallocated
+   * @param[in] size copied element count
+   * @param[in] capacity new storage element count
+   * @param[in] elem_size element bytes
+   * */
+  void on_reallocate(std::size_t size, std::size_t capacity, std::size_t elem_size) {
+    site->reallocations.fetch_add(1, std::memory_order_relaxed);
+    site->copied_bytes.fetch_add(size * elem_size, std::memory_order_relaxed);
+    vector_stats_site::raise(site->peak_capacity_bytes, capacity * elem_size);
+    on_size(size);
+  }
+
+  /**
+   * @brief elements are shifted in place for insert
+   * @param[in] count shifted element count
+   * @param[in] elem_size element bytes
+   * */
+  void on_shift(std::size_t count, std::size_t elem_size) {
+    site->shifted_bytes.fetch_add(count * elem_size, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief size is going to shrink, remember the peak before it
+   * @param[in] size current element count
+   * */
+  void on_size(std::size_t size) {
+    if (size > peak_size)
+      peak_size = size;
+  }
+
+  /**
+   * @brief storage is replaced by copy assign, it is not counted on destroy
+   * */
+  void discard() {
+    site = nullptr;
+  }
+
+  /**
+   * @brief vector is destroyed, empty and discarded storage are not counted
+   * @param[in] size final element count
+   * @param[in] capacity final storage element count
+   * @param[in] elem_size element bytes
+   * */
+  void on_destroy(std::size_t size, std::size_t capacity, std::size_t elem_size) {
+    if (capacity == 0 || site == nullptr)
+      return;
+    on_size(size);
+    site->instances.fetch_add(1, std::memory_order_relaxed);
+    vector_stats_site::raise(site->peak_capacity_bytes, capacity * elem_size);
+    vector_stats_site::raise(site->peak_size, peak_size);
+    site->total_peak_size.fetch_add(peak_size, std::memory_order_relaxed);
+    site->total_final_capacity_bytes.fetch_add(capacity * elem_size, std::memory_order_relaxed);
+    site->total_final_size_bytes.fetch_add(size * elem_size, std::memory_order_relaxed);
+  }
+
+  /// counting site
+  vector_stats_site* site { vector_stats::untagged() };
+  /// largest element count seen
+  std::size_t peak_size { 0 };
+};
+
+// run hook on vector stats slot
+#define __STL_VECTOR_STATS_HOOK(expr) (expr)
+
+// tag vec with label, nullptr label use call site
+#define __STL_VECTOR_TRACK(vec, label) \
+  do { \
+    static stl::vector_stats_site __stl_vector_site((label), __FILE__, __LINE__); \
+    (vec).track_stats(&__stl_vector_site); \
+  } while (0)
+
+#else
+
+#define __STL_VECTOR_STATS_HOOK(expr) ((void)0)
+#define __STL_VECTOR_TRACK(vec, label) ((void)(vec))
+
+#endif // __STL_VECTOR_STATS
+
+}
+
+#endif // !__STL_VECTOR_STATS_H__
@@ -0,0 +1,118 @@
+// check alloc_maintainer trim tick release idle chunks but keep the watermark reserve
+// build: g++ -std=c++17 -O2 -pthread -I../src alloc_maintainer_check.cpp -o alloc_maintainer_check
+// usage: alloc_maintainer_check
+
+#include "stl_alloc.h"
+#include "stl_alloc_maintainer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// every case use its own static pool
+typedef stl::_default_alloc_template<true, 11> refill_pool;
+typedef stl::_default_alloc_template<true, 12> idle_pool;
+typedef stl::_default_alloc_template<true, 13> direct_pool;
+typedef stl::_default_alloc_template<true, 14> bounded_pool;
+
+/// failed checks
+int failures = 0;
+
+/**
+ * @brief report failed check
+ * @param[in] ok check result
+ * @param[in] what check name
+ * */
+void expect(bool ok, const char* what) {
+  std::printf("%-52s %s\n", what, ok ? "ok" : "FAILED");
+  if (!ok)
+    failures++;
+}
+
+/**
+ * @brief let maintainer run exactly the start replenish, then one trim tick
+ *        interval is long, so the tick only happen on wakeup
+ * @param[in] maintainer stopped maintainer
+ * */
+template<typename Alloc>
+void start_and_tick(stl::alloc_maintainer<Alloc>& maintainer) {
+  maintainer.start();
+  // trim interval must elapse before wakeup
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  maintainer.wakeup();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  maintainer.stop();
+}
+
+/**
+ * @brief allocate count blocks of size then free all of them
+ * @param[in] size block size
+ * @param[in] count block count
+ * */
+template<typename Alloc>
+void churn(std::size_t size, std::size_t count) {
+  std::vector<void*> blocks(count);
+  for (void*& block : blocks)
+    block = Alloc::allocate(size);
+  for (void* block : blocks)
+    Alloc::deallocate(block, size);
+}
+
+}
+
+int main() {
+  const std::chrono::milliseconds hour(3600 * 1000);
+  const std::chrono::milliseconds tick(1);
+  // reserve refilled by start is idle, a trim tick must not release it
+  {
+    stl::alloc_watermark mark { 64, 100, 400 };
+    stl::alloc_maintainer<refill_pool> maintainer(&mark, 1, hour, tick);
+    start_and_tick(maintainer);
+    expect(refill_pool::free_count(64, mark.high) >= mark.high,
+           "refilled reserve survive trim tick");
+  }
+  // idle chunks beyond the reserve are still released
+  {
+    churn<idle_pool>(64, 20000);
+    std::size_t before = idle_pool::max_size();
+    stl::alloc_watermark mark { 64, 100, 400 };
+    stl::alloc_maintainer<idle_pool> maintainer(&mark, 1, hour, tick);
+    start_and_tick(maintainer);
+    std::size_t after = idle_pool::max_size();
+    std::printf("pool heap %zu -> %zu bytes\n", before, after);
+    expect(after < before, "idle chunks beyond reserve released");
+    expect(idle_pool::free_count(64, mark.high) >= mark.high, "reserve kept after release");
+  }
+  // direct trim, with and without keep
+  {
+    churn<direct_pool>(32, 5000);
+    stl::alloc_prewarm_entry keep { 32, 300 };
+    direct_pool::trim(&keep, 1);
+    expect(direct_pool::free_count(32, keep.count) >= keep.count, "trim keep count blocks");
+    direct_pool::trim();
+    expect(direct_pool::max_size() == 0, "trim without keep release every idle chunk");
+  }
+  // bounded trim release part of the idle chunks per call, and all of them over calls
+  {
+    churn<bounded_pool>(48, 5000);
+    std::size_t before = bounded_pool::max_size();
+    bounded_pool::trim(nullptr, 0, 4);
+    std::size_t after = bounded_pool::max_size();
+    expect(after > 0 && after < before, "bounded trim release only some chunks");
+    std::size_t calls = 1;
+    while (bounded_pool::max_size() != 0 && calls < 100000) {
+      bounded_pool::trim(nullptr, 0, 4);
+      calls++;
+    }
+    std::printf("bounded trim release %zu bytes in %zu calls\n", before, calls);
+    expect(bounded_pool::max_size() == 0, "bounded trim release everything over calls");
+  }
+  if (failures != 0) {
+    std::fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
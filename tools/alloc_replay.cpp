@@ -0,0 +1,44 @@
+// replay allocation trace recorded by alloc_trace against allocators
+// build: g++ -std=c++17 -O2 -I../src alloc_replay.cpp -o alloc_replay
+// usage: alloc_replay <trace file>
+
+#include "stl_alloc.h"
+#include "stl_alloc_replay.h"
+
+#include <cstdio>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    std::fprintf(stderr, "usage: %s <trace file>\n", argv[0]);
+    return 1;
+  }
+  std::vector<stl::alloc_trace_record> records;
+  if (!stl::load_alloc_trace(argv[1], records)) {
+    std::fprintf(stderr, "invalid trace file: %s\n", argv[1]);
+    return 1;
+  }
+  std::vector<stl::alloc_replay_op> ops;
+  std::size_t slot_count = stl::compile_alloc_trace(records, ops);
+  std::printf("records=%zu replayed=%zu\n", records.size(), ops.size());
+  // every configuration use its own static pool
+  stl::print_alloc_replay_report("malloc_alloc",
+      stl::replay_alloc_trace<stl::malloc_alloc>(ops, slot_count));
+  stl::print_alloc_replay_report("pool 8/128/20",
+      stl::replay_alloc_trace<stl::_default_alloc_template<false, 0>>(ops, slot_count));
+  stl::print_alloc_replay_report("pool 8/256/20",
+      stl::replay_alloc_trace<stl::_default_alloc_template<false, 0, 8, 256>>(ops, slot_count));
+  stl::print_alloc_replay_report("pool 16/128/20",
+      stl::replay_alloc_trace<stl::_default_alloc_template<false, 0, 16, 128>>(ops, slot_count));
+  stl::print_alloc_replay_report("pool 16/512/20",
+      stl::replay_alloc_trace<stl::_default_alloc_template<false, 0, 16, 512>>(ops, slot_count));
+  stl::print_alloc_replay_report("pool 8/128/64",
+      stl::replay_alloc_trace<stl::_default_alloc_template<false, 0, 8, 128, 64>>(ops, slot_count));
+  // peak live blocks, feed to alloc::prewarm at startup
+  std::vector<stl::alloc_prewarm_entry> profile;
+  stl::build_prewarm_profile<stl::alloc>(records, profile);
+  std::printf("prewarm profile for alloc:\n");
+  for (const stl::alloc_prewarm_entry& entry : profile)
+    std::printf("  { %zu, %zu },\n", entry.size, entry.count);
+  return 0;
+}
@@ -0,0 +1,153 @@
+// check alloc_sampler live records and heap_v2 profile with every allocation sampled
+// build: g++ -std=c++17 -O2 -D__STL_ALLOC_SAMPLE -I../src alloc_sample_check.cpp
+//        -o alloc_sample_check
+// usage: alloc_sample_check [temp dir], default /tmp
+
+#include "stl_alloc.h"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include <unistd.h>
+
+#ifndef __STL_ALLOC_SAMPLE
+#error "build with -D__STL_ALLOC_SAMPLE"
+#endif
+
+namespace {
+
+/// failed checks
+int failures = 0;
+
+/**
+ * @brief report failed check
+ * @param[in] ok check result
+ * @param[in] what check name
+ * */
+void expect(bool ok, const char* what) {
+  std::printf("%-52s %s\n", what, ok ? "ok" : "FAILED");
+  if (!ok)
+    failures++;
+}
+
+// totals parsed from heap_v2 profile
+struct profile {
+  /// header parsed
+  bool valid { false };
+  /// live sample count in header
+  std::size_t count { 0 };
+  /// live sample bytes in header
+  std::size_t bytes { 0 };
+  /// sample rate in header
+  std::size_t rate { 0 };
+  /// sum of sample counts of stack lines
+  std::size_t stack_count { 0 };
+  /// sum of sample bytes of stack lines
+  std::size_t stack_bytes { 0 };
+};
+
+/**
+ * @brief dump profile and parse header and stack lines
+ * @param[in] path profile path
+ * */
+profile dump_profile(const std::string& path) {
+  profile result;
+  if (!stl::alloc_sampler::dump(path.c_str()))
+    return result;
+  std::FILE* file = std::fopen(path.c_str(), "r");
+  if (file == nullptr)
+    return result;
+  std::size_t total_count = 0;
+  std::size_t total_bytes = 0;
+  char line[4096];
+  result.valid = std::fgets(line, sizeof(line), file) != nullptr &&
+                 std::sscanf(line, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu",
+                             &result.count, &result.bytes, &total_count, &total_bytes,
+                             &result.rate) == 5 &&
+                 total_count == result.count && total_bytes == result.bytes;
+  // stack lines until blank line before mapped libraries
+  while (std::fgets(line, sizeof(line), file) != nullptr && line[0] != '\n') {
+    std::size_t count = 0;
+    std::size_t bytes = 0;
+    if (std::sscanf(line, " %zu: %zu [", &count, &bytes) != 2) {
+      result.valid = false;
+      break;
+    }
+    result.stack_count += count;
+    result.stack_bytes += bytes;
+  }
+  std::fclose(file);
+  return result;
+}
+
+/**
+ * @brief check profile hold count samples of bytes
+ * @param[in] prof parsed profile
+ * @param[in] count expected sample count
+ * @param[in] bytes expected sample bytes
+ * */
+bool holds(const profile& prof, std::size_t count, std::size_t bytes) {
+  return prof.valid && prof.count == count && prof.bytes == bytes &&
+         prof.stack_count == count && prof.stack_bytes == bytes;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  if (argc > 2) {
+    std::fprintf(stderr, "usage: %s [temp dir]\n", argv[0]);
+    return 1;
+  }
+  std::string path = std::string(argc == 2 ? argv[1] : "/tmp") + "/alloc_sample_check." +
+                     std::to_string(::getpid());
+  // mean interval of 1 byte, every block of 64 bytes or more is sampled
+  const std::size_t small = 64;
+  const std::size_t large = 4096;
+  expect(stl::alloc_sampler::start(1), "start with forced rate");
+  // first allocation of a thread only arm its countdown
+  stl::alloc::deallocate(stl::alloc::allocate(small), small);
+  expect(holds(dump_profile(path), 0, 0), "arming allocation not sampled");
+  // pool blocks are sampled by pool, large ones by malloc_alloc
+  std::vector<void*> smalls(100);
+  std::vector<void*> larges(20);
+  for (void*& block : smalls)
+    block = stl::alloc::allocate(small);
+  for (void*& block : larges)
+    block = stl::alloc::allocate(large);
+  profile prof = dump_profile(path);
+  expect(prof.valid && prof.rate == 1, "header parsed with forced rate");
+  expect(holds(prof, 120, 100 * small + 20 * large), "every live block sampled");
+  for (std::size_t index = 0; index < 50; index++)
+    stl::alloc::deallocate(smalls[index], small);
+  expect(holds(dump_profile(path), 70, 50 * small + 20 * large), "freed blocks removed");
+  // free while suspended, e.g. by release handler during chunk refill
+  {
+    stl::alloc_sampler::suspend_guard guard;
+    for (std::size_t index = 50; index < 60; index++)
+      stl::alloc::deallocate(smalls[index], small);
+    for (std::size_t index = 0; index < 10; index++)
+      stl::alloc::deallocate(larges[index], large);
+  }
+  expect(holds(dump_profile(path), 50, 40 * small + 10 * large),
+         "blocks freed while suspended removed");
+  // stopped sampler take no sample, but still remove live ones
+  stl::alloc_sampler::stop();
+  std::vector<void*> unsampled(50);
+  for (void*& block : unsampled)
+    block = stl::alloc::allocate(small);
+  for (std::size_t index = 60; index < 100; index++)
+    stl::alloc::deallocate(smalls[index], small);
+  for (std::size_t index = 10; index < 20; index++)
+    stl::alloc::deallocate(larges[index], large);
+  expect(holds(dump_profile(path), 0, 0), "stopped sampler remove all live samples");
+  for (void* block : unsampled)
+    stl::alloc::deallocate(block, small);
+  expect(stl::alloc_sampler::dropped() == 0, "no sample dropped");
+  ::unlink(path.c_str());
+  if (failures != 0) {
+    std::fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,158 @@
+// check bit_vector assign_range and bit_rank_select against naive scan of std::vector<bool>
+// build: g++ -std=c++17 -O2 -I../src bit_vector_check.cpp -o bit_vector_check
+//        add -fsanitize=address to catch reads past the last word
+// usage: bit_vector_check [random rounds], default 200
+
+#include "stl_bit_vector.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+/// failed checks
+std::size_t failures = 0;
+
+/**
+ * @brief report one mismatch, first ones are printed
+ * @param[in] name case name
+ * @param[in] how checked operation
+ * @param[in] size bit count
+ * @param[in] pos pos or rank
+ * @param[in] got result
+ * @param[in] expect expected result
+ * */
+void mismatch(const char* name, const char* how, std::size_t size, std::size_t pos,
+              std::size_t got, std::size_t expect) {
+  if (failures++ < 20)
+    std::fprintf(stderr, "%s size %zu: %s(%zu) = %zu, expect %zu\n", name, size, how, pos, got,
+                 expect);
+}
+
+/**
+ * @brief check bits, count, rank and select of every pos against model
+ * @param[in] name case name
+ * @param[in] bits bit vector
+ * @param[in] model expected bits
+ * */
+void check(const char* name, const stl::bit_vector<>& bits, const std::vector<bool>& model) {
+  std::size_t size = model.size();
+  if (bits.size() != size) {
+    mismatch(name, "size", size, 0, bits.size(), size);
+    return;
+  }
+  // bits after size must stay zero, whole words are counted
+  stl::bit_rank_select<> index(bits);
+  std::size_t ones = 0;
+  for (std::size_t pos = 0; pos <= size; pos++) {
+    if (bits.count(pos) != ones)
+      mismatch(name, "count", size, pos, bits.count(pos), ones);
+    if (index.rank(pos) != ones)
+      mismatch(name, "rank", size, pos, index.rank(pos), ones);
+    if (pos == size)
+      break;
+    if (bits[pos] != model[pos])
+      mismatch(name, "bit", size, pos, bits[pos], model[pos]);
+    if (model[pos]) {
+      if (index.select(ones) != pos)
+        mismatch(name, "select", size, ones, index.select(ones), pos);
+      ones++;
+    }
+  }
+  if (bits.count() != ones)
+    mismatch(name, "count", size, size, bits.count(), ones);
+  if (index.count() != ones)
+    mismatch(name, "index count", size, size, index.count(), ones);
+  // rank out of set bits select size
+  if (index.select(ones) != size)
+    mismatch(name, "select", size, ones, index.select(ones), size);
+}
+
+/**
+ * @brief apply assign_range to both vector and model, then check
+ * @param[in] name case name
+ * @param[in] bits bit vector
+ * @param[in] model expected bits
+ * @param[in] first first pos
+ * @param[in] last last pos
+ * @param[in] value bit value
+ * */
+void assign(const char* name, stl::bit_vector<>& bits, std::vector<bool>& model,
+            std::size_t first, std::size_t last, bool value) {
+  bits.assign_range(first, last, value);
+  for (std::size_t pos = first; pos < last; pos++)
+    model[pos] = value;
+  check(name, bits, model);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  int rounds = 200;
+  if (argc > 2) {
+    std::fprintf(stderr, "usage: %s [random rounds]\n", argv[0]);
+    return 1;
+  }
+  if (argc == 2)
+    rounds = std::atoi(argv[1]);
+  std::mt19937_64 random(42);
+  // sizes around word (64 bits) and rank block (512 bits) boundaries
+  const std::size_t sizes[] = { 0, 1, 63, 64, 65, 511, 512, 513, 1023, 1024, 1025, 4103 };
+  for (std::size_t size : sizes) {
+    stl::bit_vector<> zeros(size);
+    check("empty or zero", zeros, std::vector<bool>(size, false));
+    stl::bit_vector<> ones(size, true);
+    check("all ones", ones, std::vector<bool>(size, true));
+    stl::bit_vector<> set(size);
+    set.set();
+    check("set all", set, std::vector<bool>(size, true));
+    // every range between boundary positions, set on zeros then clear on ones
+    std::vector<std::size_t> edges;
+    for (std::size_t edge : { 0, 1, 63, 64, 65, 127, 128, 511, 512, 513, 1024 }) {
+      if (edge <= size)
+        edges.push_back(edge);
+    }
+    if (size > 0)
+      edges.push_back(size - 1);
+    edges.push_back(size);
+    for (std::size_t first : edges) {
+      for (std::size_t last : edges) {
+        if (first > last)
+          continue;
+        stl::bit_vector<> bits(size);
+        std::vector<bool> model(size, false);
+        assign("range set", bits, model, first, last, true);
+        stl::bit_vector<> full(size, true);
+        std::vector<bool> full_model(size, true);
+        assign("range clear", full, full_model, first, last, false);
+      }
+    }
+  }
+  // random bits, then random ranges over them
+  for (int round = 0; round < rounds; round++) {
+    std::size_t size = random() % 3000;
+    // dense, sparse and mostly set
+    unsigned percent = round % 3 == 0 ? 50 : round % 3 == 1 ? 2 : 98;
+    stl::bit_vector<> bits(size);
+    std::vector<bool> model(size);
+    for (std::size_t pos = 0; pos < size; pos++) {
+      model[pos] = random() % 100 < percent;
+      if (model[pos])
+        bits.set(pos);
+    }
+    check("random", bits, model);
+    for (int step = 0; step < 4 && size > 0; step++) {
+      std::size_t first = random() % (size + 1);
+      std::size_t last = first + random() % (size + 1 - first);
+      assign("random range", bits, model, first, last, random() % 2 == 0);
+    }
+  }
+  if (failures != 0) {
+    std::fprintf(stderr, "%zu checks failed\n", failures);
+    return 1;
+  }
+  std::printf("all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,206 @@
+// stress concurrent_vector appends from many threads, and check claimed slots stay
+// balanced when segment allocation or element construction throw
+// build: g++ -std=c++17 -O2 -pthread -I../src concurrent_vector_check.cpp
+//        -o concurrent_vector_check
+//        add -fsanitize=thread for the stress, or -fsanitize=address for the failure cases
+// usage: concurrent_vector_check [threads] [pushes per thread], default 8 20000
+
+#include "stl_concurrent_vector.h"
+
+#include <new>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+
+namespace {
+
+/// failed checks
+int failures = 0;
+
+/**
+ * @brief report failed check
+ * @param[in] ok check result
+ * @param[in] what check name
+ * */
+void expect(bool ok, const char* what) {
+  std::printf("%-52s %s\n", what, ok ? "ok" : "FAILED");
+  if (!ok)
+    failures++;
+}
+
+// malloc backed alloc, the fail_at th allocation throw bad_alloc
+struct failing_alloc {
+  static constexpr std::size_t align_size = alignof(std::max_align_t);
+  /// allocation count so far
+  static std::size_t count;
+  /// allocation number which throw, 0 never
+  static std::size_t fail_at;
+
+  static void* allocate(std::size_t size) {
+    if (++count == fail_at)
+      throw std::bad_alloc{};
+    void* ptr = std::malloc(size);
+    if (ptr == nullptr)
+      throw std::bad_alloc{};
+    return ptr;
+  }
+
+  static void deallocate(void* ptr, std::size_t) {
+    std::free(ptr);
+  }
+};
+
+/// init allocation count
+std::size_t failing_alloc::count = 0;
+/// init failing allocation number
+std::size_t failing_alloc::fail_at = 0;
+
+// element counting live objects, construct from negative value throw
+struct tracked {
+  /// live objects
+  static long live;
+  /// element value
+  int value { 0 };
+
+  tracked() noexcept { live++; }
+  explicit tracked(int v) : value(v) {
+    if (v < 0)
+      throw std::invalid_argument("negative");
+    live++;
+  }
+  tracked(const tracked& other) noexcept : value(other.value) { live++; }
+  ~tracked() { live--; }
+};
+
+/// init live objects
+long tracked::live = 0;
+
+typedef stl::concurrent_vector<tracked, failing_alloc> tracked_vector;
+
+/**
+ * @brief append count elements, return how many throw bad_alloc
+ * @param[in] vec vector
+ * @param[in] count append count
+ * */
+std::size_t push_count(tracked_vector& vec, std::size_t count) {
+  std::size_t failed = 0;
+  for (std::size_t index = 0; index < count; index++) {
+    try {
+      vec.emplace_back(int(index));
+    } catch (const std::bad_alloc&) {
+      failed++;
+    }
+  }
+  return failed;
+}
+
+/**
+ * @brief many threads push strings, each remember its indices, then verify all
+ * @param[in] threads thread count
+ * @param[in] pushes pushes per thread
+ * */
+void stress(std::size_t threads, std::size_t pushes) {
+  stl::concurrent_vector<std::string> vec;
+  std::vector<std::vector<std::size_t>> indices(threads);
+  std::vector<std::thread> workers;
+  for (std::size_t thread = 0; thread < threads; thread++) {
+    workers.emplace_back([&, thread]() {
+      std::vector<std::size_t>& mine = indices[thread];
+      mine.reserve(pushes);
+      for (std::size_t index = 0; index < pushes; index++) {
+        std::string text = std::to_string(thread) + ":" + std::to_string(index);
+        // long strings leave the inline buffer
+        if (index % 4 == 0)
+          text.resize(64, 'x');
+        mine.push_back(vec.push_back(text));
+        // read back own element while others append
+        if (vec[mine.back()].compare(0, text.size(), text) != 0)
+          std::abort();
+      }
+    });
+  }
+  for (std::thread& worker : workers)
+    worker.join();
+  bool ok = vec.size() == threads * pushes;
+  for (std::size_t thread = 0; ok && thread < threads; thread++) {
+    for (std::size_t index = 0; ok && index < pushes; index++) {
+      std::string text = std::to_string(thread) + ":" + std::to_string(index);
+      if (index % 4 == 0)
+        text.resize(64, 'x');
+      ok = vec[indices[thread][index]] == text;
+    }
+  }
+  expect(ok, "every pushed string found at returned index");
+  expect(vec.capacity() >= vec.size(), "capacity cover size");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  std::size_t threads = 8;
+  std::size_t pushes = 20000;
+  if (argc > 3) {
+    std::fprintf(stderr, "usage: %s [threads] [pushes per thread]\n", argv[0]);
+    return 1;
+  }
+  if (argc >= 2)
+    threads = std::strtoull(argv[1], nullptr, 10);
+  if (argc == 3)
+    pushes = std::strtoull(argv[2], nullptr, 10);
+  stress(threads, pushes);
+  // second segment, index 16 to 47, fail to allocate, the whole segment is failed
+  {
+    failing_alloc::count = 0;
+    failing_alloc::fail_at = 2;
+    tracked_vector vec;
+    std::size_t failed = push_count(vec, 64);
+    expect(failed == 32, "append into failed segment throw bad_alloc");
+    expect(vec.size() == 64 && tracked::live == 32, "failed slots claimed but not constructed");
+    expect(vec[15].value == 15 && vec[48].value == 48, "segments around failed one usable");
+    expect(vec.capacity() == 16, "capacity stop at failed segment");
+    vec.clear();
+    expect(tracked::live == 0, "clear skip failed segment");
+    expect(push_count(vec, 20) == 0 && vec[16].value == 16, "clear reset failed segment");
+  }
+  expect(tracked::live == 0, "destructor destroy constructed only");
+  // grow_by fail in second segment, claimed slots of later segments are filled
+  {
+    failing_alloc::count = 0;
+    failing_alloc::fail_at = 2;
+    tracked_vector vec;
+    bool thrown = false;
+    try {
+      vec.grow_by(100);
+    } catch (const std::bad_alloc&) {
+      thrown = true;
+    }
+    expect(thrown && vec.size() == 100, "grow_by throw, range stay claimed");
+    expect(tracked::live == 16 + 52, "grow_by fill claimed slots after failed segment");
+  }
+  expect(tracked::live == 0, "grow_by failure destroy balanced");
+  // construction throw, slot is value initialized
+  {
+    failing_alloc::fail_at = 0;
+    tracked_vector vec;
+    vec.emplace_back(1);
+    bool thrown = false;
+    try {
+      vec.emplace_back(-1);
+    } catch (const std::invalid_argument&) {
+      thrown = true;
+    }
+    vec.emplace_back(3);
+    expect(thrown && vec.size() == 3 && vec[1].value == 0 && vec[2].value == 3,
+           "throwing construct leave value initialized slot");
+  }
+  expect(tracked::live == 0, "construct failure destroy balanced");
+  if (failures != 0) {
+    std::fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,130 @@
+// compare flat_map with std::map on lookup time and memory
+// build: g++ -std=c++17 -O2 -I../src flat_map_bench.cpp -o flat_map_bench
+// usage: flat_map_bench [max pair count], default 1000000
+
+#include "stl_flat_map.h"
+
+#include <map>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+/// bytes requested by std::map nodes, malloc overhead not included
+std::size_t map_bytes = 0;
+
+// std::allocator counting requested bytes
+template<typename T>
+struct counting_allocator : std::allocator<T> {
+  template<typename U>
+  struct rebind { typedef counting_allocator<U> other; };
+
+  counting_allocator() {}
+  template<typename U>
+  counting_allocator(const counting_allocator<U>&) {}
+
+  T* allocate(std::size_t count) {
+    map_bytes += count * sizeof(T);
+    return std::allocator<T>::allocate(count);
+  }
+
+  void deallocate(T* ptr, std::size_t count) {
+    map_bytes -= count * sizeof(T);
+    std::allocator<T>::deallocate(ptr, count);
+  }
+};
+
+typedef std::map<std::uint64_t, std::uint64_t, std::less<std::uint64_t>,
+                 counting_allocator<std::pair<const std::uint64_t, std::uint64_t>>> map_type;
+typedef stl::flat_map<std::uint64_t, std::uint64_t> flat_type;
+
+/**
+ * @brief run func rounds times after one warm up, return ns per lookup
+ * @param[in] count lookups per round
+ * @param[in] func round func
+ * */
+template<typename Func>
+double time_rounds(std::size_t count, Func func) {
+  std::size_t rounds = 4000000 / count + 1;
+  func();
+  auto begin = std::chrono::steady_clock::now();
+  for (std::size_t round = 0; round < rounds; round++)
+    func();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - begin).count() / (rounds * count);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  std::size_t max_count = 1000000;
+  if (argc > 2) {
+    std::fprintf(stderr, "usage: %s [max pair count]\n", argv[0]);
+    return 1;
+  }
+  if (argc == 2)
+    max_count = std::strtoull(argv[1], nullptr, 10);
+  std::mt19937_64 random(42);
+  std::uint64_t sum = 0;
+  std::printf("%10s %10s %10s %9s %10s %10s %9s %12s %12s\n", "count", "map hit", "flat hit",
+              "speedup", "map miss", "flat miss", "speedup", "map byte", "flat byte");
+  for (std::size_t count = 16; count <= max_count; count *= 4) {
+    // even keys are present, odd keys miss
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> pairs(count);
+    for (auto& pair : pairs) {
+      pair.first = random() & ~std::uint64_t(1);
+      pair.second = pair.first >> 1;
+    }
+    map_type map(pairs.begin(), pairs.end());
+    flat_type flat;
+    flat.build(pairs.data(), count);
+    if (flat.size() != map.size()) {
+      std::fprintf(stderr, "count %zu: size mismatch\n", count);
+      return 1;
+    }
+    // lookups in random order, so neither container walk memory in key order
+    std::vector<std::uint64_t> hits(count);
+    for (std::size_t index = 0; index < count; index++)
+      hits[index] = pairs[index].first;
+    std::shuffle(hits.begin(), hits.end(), random);
+    std::vector<std::uint64_t> misses(hits);
+    for (std::uint64_t& key : misses)
+      key |= 1;
+    std::uint64_t map_sum = 0;
+    std::uint64_t flat_sum = 0;
+    double map_hit = time_rounds(count, [&]() {
+      for (std::uint64_t key : hits)
+        map_sum += map.find(key)->second;
+    });
+    double flat_hit = time_rounds(count, [&]() {
+      for (std::uint64_t key : hits)
+        flat_sum += *flat.find(key);
+    });
+    double map_miss = time_rounds(count, [&]() {
+      for (std::uint64_t key : misses)
+        map_sum += map.find(key) == map.end() ? 1 : 0;
+    });
+    double flat_miss = time_rounds(count, [&]() {
+      for (std::uint64_t key : misses)
+        flat_sum += flat.find(key) == nullptr ? 1 : 0;
+    });
+    if (map_sum != flat_sum) {
+      std::fprintf(stderr, "count %zu: checksum mismatch\n", count);
+      return 1;
+    }
+    sum += flat_sum;
+    std::printf("%10zu %10.1f %10.1f %8.2fx %10.1f %10.1f %8.2fx %12zu %12zu\n", count, map_hit,
+                flat_hit, map_hit / flat_hit, map_miss, flat_miss, map_miss / flat_miss,
+                map_bytes, flat.memory_bytes());
+  }
+  // print checksum, so lookups are not optimized away
+  std::printf("checksum %llu\n", (unsigned long long)sum);
+  return 0;
+}
@@ -0,0 +1,138 @@
+// check mmap_vector in read_write, read_only and copy_on_write mode on a temp file
+// build: g++ -std=c++17 -O2 -I../src mmap_vector_check.cpp -o mmap_vector_check
+// usage: mmap_vector_check [temp dir], default /tmp
+
+#include "stl_mmap_vector.h"
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace {
+
+/// failed checks
+int failures = 0;
+
+/**
+ * @brief report failed check
+ * @param[in] ok check result
+ * @param[in] what check name
+ * */
+void expect(bool ok, const char* what) {
+  std::printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+  if (!ok)
+    failures++;
+}
+
+/**
+ * @brief check if func throw logic_error
+ * @param[in] func tested func
+ * */
+template<typename Func>
+bool throws_logic_error(Func func) {
+  try {
+    func();
+  } catch (const std::logic_error&) {
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief file size in bytes, -1 if not exist
+ * @param[in] path file path
+ * */
+long long file_size(const char* path) {
+  struct stat st;
+  return ::stat(path, &st) == 0 ? (long long)st.st_size : -1;
+}
+
+/**
+ * @brief check elements are index * 3 from first to last
+ * @param[in] vec vector
+ * @param[in] first first index
+ * @param[in] last end index
+ * */
+bool holds_pattern(const stl::mmap_vector<std::uint64_t>& vec, std::size_t first,
+                   std::size_t last) {
+  for (std::size_t index = first; index < last; index++) {
+    if (vec[index] != index * 3)
+      return false;
+  }
+  return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  if (argc > 2) {
+    std::fprintf(stderr, "usage: %s [temp dir]\n", argv[0]);
+    return 1;
+  }
+  std::string path = std::string(argc == 2 ? argv[1] : "/tmp") + "/mmap_vector_check." +
+                     std::to_string(::getpid());
+  typedef stl::mmap_vector<std::uint64_t> vector;
+  const std::size_t count = 10000;
+  // read_write, grow by push_back across pages, then shrink and grow inside capacity
+  {
+    vector vec(path.c_str(), vector::read_write);
+    expect(vec.empty(), "read_write create empty file");
+    for (std::size_t index = 0; index < count; index++)
+      vec.push_back(index * 3);
+    expect(vec.size() == count && holds_pattern(vec, 0, count), "read_write push_back");
+    vec.resize(count / 2);
+    vec.resize(count);
+    bool zero = true;
+    for (std::size_t index = count / 2; index < count; index++)
+      zero = zero && vec[index] == 0;
+    expect(zero, "read_write resize zero fill reused tail");
+    for (std::size_t index = count / 2; index < count; index++)
+      vec[index] = index * 3;
+    expect(vec.flush(), "read_write flush");
+    expect(file_size(path.c_str()) == (long long)(vec.capacity() * sizeof(std::uint64_t)),
+           "read_write file hold capacity before close");
+  }
+  expect(file_size(path.c_str()) == (long long)(count * sizeof(std::uint64_t)),
+         "read_write close truncate to size");
+  // read_only, read back, every write path throw, shrink is allowed
+  {
+    vector vec(path.c_str(), vector::read_only);
+    expect(vec.size() == count && holds_pattern(vec, 0, count), "read_only load");
+    expect(throws_logic_error([&]() { vec.push_back(1); }), "read_only push_back at capacity");
+    vec.pop_back();
+    expect(throws_logic_error([&]() { vec.push_back(99); }), "read_only push_back in capacity");
+    vec.clear();
+    expect(throws_logic_error([&]() { vec.resize(10); }), "read_only resize larger in capacity");
+    expect(throws_logic_error([&]() { vec.reserve(count * 2); }), "read_only reserve");
+    vec.resize(0);
+    expect(vec.empty(), "read_only resize smaller");
+  }
+  // copy_on_write, write in capacity stay private, grow throw
+  {
+    vector vec(path.c_str(), vector::copy_on_write);
+    expect(holds_pattern(vec, 0, count), "copy_on_write load");
+    vec[0] = 12345;
+    vec.pop_back();
+    vec.push_back(7);
+    expect(vec[0] == 12345 && vec.back() == 7, "copy_on_write write in capacity");
+    expect(throws_logic_error([&]() { vec.push_back(1); }), "copy_on_write push_back at capacity");
+    vec.resize(count / 2);
+    vec.resize(count);
+    expect(vec[count - 1] == 0, "copy_on_write resize zero fill reused tail");
+  }
+  {
+    vector vec(path.c_str(), vector::read_only);
+    expect(vec.size() == count && holds_pattern(vec, 0, count),
+           "copy_on_write change not written to file");
+  }
+  ::unlink(path.c_str());
+  if (failures != 0) {
+    std::fprintf(stderr, "%d checks failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,155 @@
+// compare node containers on pool_allocator with std::allocator
+// build: g++ -std=c++17 -O2 -I../src node_alloc_bench.cpp -o node_alloc_bench
+// usage: node_alloc_bench [element count], default 1000000
+
+#include "stl_alloc.h"
+
+#include <map>
+#include <list>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+namespace {
+
+// single thread pool, no lock on free list
+typedef stl::_default_alloc_template<false, 1> nolock_alloc;
+
+template<typename Alloc>
+using map_type = std::map<std::uint64_t, std::uint64_t, std::less<std::uint64_t>,
+                          typename Alloc::template rebind<
+                              std::pair<const std::uint64_t, std::uint64_t>>::other>;
+
+template<typename Alloc>
+using list_type = std::list<std::uint64_t, typename Alloc::template rebind<std::uint64_t>::other>;
+
+template<typename Alloc>
+using hash_type = std::unordered_map<std::uint64_t, std::uint64_t, std::hash<std::uint64_t>,
+                                     std::equal_to<std::uint64_t>,
+                                     typename Alloc::template rebind<
+                                         std::pair<const std::uint64_t, std::uint64_t>>::other>;
+
+/**
+ * @brief run func once, return ns per element
+ * @param[in] count element count
+ * @param[in] func round func
+ * */
+template<typename Func>
+double time_once(std::size_t count, Func func) {
+  auto begin = std::chrono::steady_clock::now();
+  func();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - begin).count() / count;
+}
+
+/**
+ * @brief fill, churn half of the keys, scan, then destroy a map like container
+ * @param[in] keys random keys
+ * @param[out] sum checksum of scan, keep work alive
+ * */
+template<typename Map>
+double bench_map(const std::vector<std::uint64_t>& keys, std::uint64_t& sum) {
+  return time_once(keys.size(), [&]() {
+    Map map;
+    for (std::uint64_t key : keys)
+      map.emplace(key, key);
+    // erase and insert again, node is freed then allocated at once
+    for (std::size_t index = 0; index < keys.size(); index += 2) {
+      map.erase(keys[index]);
+      map.emplace(keys[index] + 1, keys[index]);
+    }
+    for (const auto& node : map)
+      sum += node.second;
+  });
+}
+
+/**
+ * @brief push to both ends, pop half, scan, then destroy a list
+ * @param[in] keys random keys
+ * @param[out] sum checksum of scan, keep work alive
+ * */
+template<typename List>
+double bench_list(const std::vector<std::uint64_t>& keys, std::uint64_t& sum) {
+  return time_once(keys.size(), [&]() {
+    List list;
+    for (std::size_t index = 0; index < keys.size(); index++) {
+      if (index % 2 == 0)
+        list.push_back(keys[index]);
+      else
+        list.push_front(keys[index]);
+    }
+    for (std::size_t index = 0; index < keys.size() / 2; index++) {
+      list.pop_front();
+      list.push_back(keys[index]);
+    }
+    for (std::uint64_t value : list)
+      sum += value;
+  });
+}
+
+/**
+ * @brief print one container row
+ * @param[in] name container name
+ * @param[in] count element count
+ * @param[in] std_ns std::allocator ns per element
+ * @param[in] pool_ns pool_allocator over alloc ns per element
+ * @param[in] nolock_ns pool_allocator over single thread pool ns per element
+ * */
+void report(const char* name, std::size_t count, double std_ns, double pool_ns,
+            double nolock_ns) {
+  std::printf("%-14s %10zu %10.1f %10.1f %10.1f %8.2fx %8.2fx\n", name, count, std_ns, pool_ns,
+              nolock_ns, std_ns / pool_ns, std_ns / nolock_ns);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  std::size_t max_count = 1000000;
+  if (argc > 2) {
+    std::fprintf(stderr, "usage: %s [element count]\n", argv[0]);
+    return 1;
+  }
+  if (argc == 2)
+    max_count = std::strtoull(argv[1], nullptr, 10);
+  std::mt19937_64 random(42);
+  std::uint64_t sum = 0;
+  std::printf("%-14s %10s %10s %10s %10s %9s %9s\n", "container", "count", "std ns", "pool ns",
+              "nolock ns", "pool", "nolock");
+  for (std::size_t count = 1000; count <= max_count; count *= 10) {
+    std::vector<std::uint64_t> keys(count);
+    for (std::uint64_t& key : keys)
+      key = random() & ~std::uint64_t(1);
+    // every container run twice, the first one warm up the pools and the heap
+    for (int round = 0; round < 2; round++) {
+      double std_ns = bench_map<map_type<std::allocator<int>>>(keys, sum);
+      double pool_ns = bench_map<map_type<stl::pool_allocator<int>>>(keys, sum);
+      double nolock_ns = bench_map<map_type<stl::pool_allocator<int, nolock_alloc>>>(keys, sum);
+      if (round == 1)
+        report("map", count, std_ns, pool_ns, nolock_ns);
+    }
+    for (int round = 0; round < 2; round++) {
+      double std_ns = bench_map<hash_type<std::allocator<int>>>(keys, sum);
+      double pool_ns = bench_map<hash_type<stl::pool_allocator<int>>>(keys, sum);
+      double nolock_ns = bench_map<hash_type<stl::pool_allocator<int, nolock_alloc>>>(keys, sum);
+      if (round == 1)
+        report("unordered_map", count, std_ns, pool_ns, nolock_ns);
+    }
+    // list node has the same size class as unordered_map node, so pool hand back nodes
+    // in the scattered order the hash map freed them, large list show that locality cost
+    for (int round = 0; round < 2; round++) {
+      double std_ns = bench_list<list_type<std::allocator<int>>>(keys, sum);
+      double pool_ns = bench_list<list_type<stl::pool_allocator<int>>>(keys, sum);
+      double nolock_ns = bench_list<list_type<stl::pool_allocator<int, nolock_alloc>>>(keys, sum);
+      if (round == 1)
+        report("list", count, std_ns, pool_ns, nolock_ns);
+    }
+  }
+  // print checksum, so scans are not optimized away
+  std::printf("checksum %llu\n", (unsigned long long)sum);
+  return 0;
+}
@@ -0,0 +1,206 @@
+// check packed_vector and delta_vector against std::vector on random and edge inputs
+// build: g++ -std=c++17 -O2 -I../src packed_vector_check.cpp -o packed_vector_check
+//        add -fsanitize=address to catch reads past the packed words
+// usage: packed_vector_check [random rounds], default 200
+
+#include "stl_packed_vector.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include <cstdint>
+
+namespace {
+
+/// failed checks
+std::size_t failures = 0;
+
+/**
+ * @brief report mismatch of one element
+ * @param[in] name case name
+ * @param[in] how access path
+ * @param[in] index element index
+ * @param[in] got decoded value
+ * @param[in] expect expected value
+ * */
+void mismatch(const char* name, const char* how, std::size_t index, std::uint64_t got,
+              std::uint64_t expect) {
+  if (failures++ < 20)
+    std::fprintf(stderr, "%s: %s[%zu] = %llu, expect %llu\n", name, how, index,
+                 (unsigned long long)got, (unsigned long long)expect);
+}
+
+/**
+ * @brief check every access path of container against expected values
+ * @param[in] name case name
+ * @param[in] packed packed_vector or delta_vector
+ * @param[in] expect expected values
+ * */
+template<typename Packed>
+void check_access(const char* name, const Packed& packed,
+                  const std::vector<std::uint64_t>& expect) {
+  if (packed.size() != expect.size()) {
+    failures++;
+    std::fprintf(stderr, "%s: size %zu, expect %zu\n", name, packed.size(), expect.size());
+    return;
+  }
+  for (std::size_t index = 0; index < expect.size(); index++) {
+    if (packed[index] != expect[index])
+      mismatch(name, "operator[]", index, packed[index], expect[index]);
+  }
+  std::size_t index = 0;
+  packed.for_each([&](std::uint64_t value) {
+    if (index < expect.size() && value != expect[index])
+      mismatch(name, "for_each", index, value, expect[index]);
+    index++;
+  });
+  if (index != expect.size()) {
+    failures++;
+    std::fprintf(stderr, "%s: for_each visit %zu, expect %zu\n", name, index, expect.size());
+  }
+  try {
+    packed.at(expect.size());
+    failures++;
+    std::fprintf(stderr, "%s: at(size) not throw\n", name);
+  } catch (const std::out_of_range&) {}
+}
+
+/**
+ * @brief check packed_vector decode from every offset of first two blocks
+ * @param[in] name case name
+ * @param[in] packed packed vector
+ * @param[in] expect expected values
+ * */
+void check_decode(const char* name, const stl::packed_vector<>& packed,
+                  const std::vector<std::uint64_t>& expect) {
+  std::vector<std::uint64_t> out(expect.size());
+  for (std::size_t first = 0; first < 130 && first <= expect.size(); first++) {
+    std::size_t count = expect.size() - first;
+    packed.decode(first, count, out.data());
+    for (std::size_t index = 0; index < count; index++) {
+      if (out[index] != expect[first + index])
+        mismatch(name, "decode", first + index, out[index], expect[first + index]);
+    }
+  }
+}
+
+/**
+ * @brief build both containers by push_back, append and build, check all of them
+ * @param[in] name case name
+ * @param[in] values input values
+ * */
+void check(const char* name, const std::vector<std::uint64_t>& values) {
+  const std::uint64_t* data = values.data();
+  std::size_t count = values.size();
+  // push_back widen on demand
+  stl::packed_vector<> pushed;
+  for (std::uint64_t value : values)
+    pushed.push_back(value);
+  check_access(name, pushed, values);
+  check_decode(name, pushed, values);
+  // append in uneven chunks, build at least width
+  stl::packed_vector<> appended;
+  for (std::size_t first = 0; first < count; first += 37)
+    appended.append(data + first, count - first < 37 ? count - first : 37);
+  check_access(name, appended, values);
+  stl::packed_vector<> built;
+  built.build(data, count);
+  check_access(name, built, values);
+  check_decode(name, built, values);
+  // set every element again in reverse, width must not shrink values
+  std::vector<std::uint64_t> reversed(values.rbegin(), values.rend());
+  for (std::size_t index = 0; index < count; index++)
+    built.set(index, reversed[index]);
+  check_access(name, built, reversed);
+  stl::delta_vector<> delta_pushed;
+  for (std::uint64_t value : values)
+    delta_pushed.push_back(value);
+  check_access(name, delta_pushed, values);
+  stl::delta_vector<> delta;
+  delta.build(data, count);
+  check_access(name, delta, values);
+}
+
+/**
+ * @brief print storage bits per value of both containers
+ * @param[in] name case name
+ * @param[in] values input values
+ * */
+void space(const char* name, const std::vector<std::uint64_t>& values) {
+  stl::packed_vector<> packed;
+  packed.build(values.data(), values.size());
+  stl::delta_vector<> delta;
+  delta.build(values.data(), values.size());
+  double count = double(values.size());
+  std::printf("%-14s %10zu %6u %12.2f %12.2f\n", name, values.size(), packed.width(),
+              packed.memory_bytes() * 8 / count, delta.memory_bytes() * 8 / count);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  int rounds = 200;
+  if (argc > 2) {
+    std::fprintf(stderr, "usage: %s [random rounds]\n", argv[0]);
+    return 1;
+  }
+  if (argc == 2)
+    rounds = std::atoi(argv[1]);
+  std::mt19937_64 random(42);
+  // counts around word, unpack block and delta block boundaries
+  const std::size_t counts[] = { 0, 1, 2, 63, 64, 65, 127, 128, 129, 255, 256, 257, 383, 384,
+                                 1000 };
+  for (std::size_t count : counts) {
+    // width 0, every value is zero
+    check("zero", std::vector<std::uint64_t>(count, 0));
+    // width 0 delta blocks with non zero base
+    check("constant", std::vector<std::uint64_t>(count, 0x123456789ull));
+    // width 64, top bit set
+    std::vector<std::uint64_t> full(count);
+    for (std::uint64_t& value : full)
+      value = random() | (std::uint64_t(1) << 63);
+    check("width 64", full);
+    // all ones, max value of width 64 and max delta of a block
+    check("all ones", std::vector<std::uint64_t>(count, ~std::uint64_t(0)));
+    std::vector<std::uint64_t> extreme(count);
+    for (std::size_t index = 0; index < count; index++)
+      extreme[index] = index % 2 == 0 ? 0 : ~std::uint64_t(0);
+    check("0 and max", extreme);
+    // zeros, then one wide value at the end, widen repack everything
+    std::vector<std::uint64_t> late(count, 0);
+    if (count > 0)
+      late.back() = ~std::uint64_t(0);
+    check("late widen", late);
+  }
+  // random width and count
+  for (int round = 0; round < rounds; round++) {
+    unsigned width = unsigned(random() % 65);
+    std::size_t count = random() % 1100;
+    std::vector<std::uint64_t> values(count);
+    for (std::uint64_t& value : values)
+      value = random() & stl::_bit_pack::mask(width);
+    check("random", values);
+    // sorted ids, small deltas inside block
+    std::uint64_t id = random();
+    for (std::uint64_t& value : values)
+      value = id += random() % 1000;
+    check("sorted", values);
+  }
+  if (failures != 0) {
+    std::fprintf(stderr, "%zu checks failed\n", failures);
+    return 1;
+  }
+  std::printf("%-14s %10s %6s %12s %12s\n", "case", "count", "width", "packed bit", "delta bit");
+  std::vector<std::uint64_t> values(1000000);
+  std::uint64_t id = 1ull << 40;
+  for (std::uint64_t& value : values)
+    value = id += random() % 64;
+  space("sorted ids", values);
+  for (std::uint64_t& value : values)
+    value = random() % 1000;
+  space("small random", values);
+  space("zero", std::vector<std::uint64_t>(1000000, 0));
+  std::printf("all checks passed\n");
+  return 0;
+}
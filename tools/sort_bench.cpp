@@ -0,0 +1,90 @@
+// compare stl::sort with std::sort, element count grow by 10x from 1K
+// build: g++ -std=c++17 -O2 -pthread -I../src sort_bench.cpp -o sort_bench
+// usage: sort_bench [max count], default 10M, 1G uint32 need 8GB memory
+
+#include "stl_algo.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+/**
+ * @brief sort input copy by both sorts, report best of rounds in ns per element
+ * @param[in] name case name
+ * @param[in] input unsorted input
+ * @param[in] comp compare
+ * */
+template<typename T, typename Compare>
+void bench(const char* name, const std::vector<T>& input, Compare comp) {
+  std::size_t count = input.size();
+  int rounds = count <= 100000 ? 10 : count <= 10000000 ? 3 : 1;
+  double best_stl = 1e30;
+  double best_std = 1e30;
+  std::vector<T> data;
+  for (int round = 0; round < rounds; round++) {
+    data = input;
+    auto begin = std::chrono::steady_clock::now();
+    stl::sort(data.data(), data.data() + count, comp);
+    auto end = std::chrono::steady_clock::now();
+    best_stl = std::min(best_stl, std::chrono::duration<double, std::nano>(end - begin).count());
+    if (!std::is_sorted(data.begin(), data.end(), comp)) {
+      std::fprintf(stderr, "%s: stl::sort result is not sorted\n", name);
+      std::exit(1);
+    }
+    data = input;
+    begin = std::chrono::steady_clock::now();
+    std::sort(data.begin(), data.end(), comp);
+    end = std::chrono::steady_clock::now();
+    best_std = std::min(best_std, std::chrono::duration<double, std::nano>(end - begin).count());
+  }
+  std::printf("%-10s %12zu %10.2f %10.2f %8.2fx\n", name, count, best_stl / count,
+              best_std / count, best_std / best_stl);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  std::size_t max_count = 10000000;
+  if (argc > 2) {
+    std::fprintf(stderr, "usage: %s [max count]\n", argv[0]);
+    return 1;
+  }
+  if (argc == 2)
+    max_count = std::strtoull(argv[1], nullptr, 10);
+  std::mt19937_64 random(42);
+  std::printf("%-10s %12s %10s %10s %9s\n", "case", "count", "stl ns", "std ns", "speedup");
+  for (std::size_t count = 1000; count <= max_count; count *= 10) {
+    std::vector<std::uint32_t> u32(count);
+    for (std::uint32_t& value : u32)
+      value = std::uint32_t(random());
+    bench("uint32", u32, std::less<std::uint32_t>());
+    std::vector<std::int64_t> i64(count);
+    for (std::int64_t& value : i64)
+      value = std::int64_t(random());
+    bench("int64", i64, std::less<std::int64_t>());
+    std::vector<double> f64(count);
+    for (double& value : f64)
+      value = std::uniform_real_distribution<double>(-1e9, 1e9)(random);
+    bench("double", f64, std::less<double>());
+    // wider than radix key, must fall back to compare sort
+    std::vector<long double> f80(f64.begin(), f64.end());
+    bench("long dbl", f80, std::less<long double>());
+    // custom compare, not radix sortable
+    bench("int64 desc", i64, std::greater<std::int64_t>());
+    if (count <= 10000000) {
+      std::vector<std::string> text(count);
+      for (std::string& value : text)
+        value = std::to_string(random() % (count * 10));
+      bench("string", text, std::less<std::string>());
+    }
+  }
+  return 0;
+}
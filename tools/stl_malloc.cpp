@@ -0,0 +1,132 @@
+// malloc replacement on top of pool, preload it under unmodified program
+// build: g++ -std=c++17 -O2 -fPIC -shared -I../src stl_malloc.cpp -o libstl_malloc.so
+// usage: LD_PRELOAD=./libstl_malloc.so <program>
+// pool lock is not reset in child, fork while other thread allocate may deadlock child
+
+#include <new>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <unistd.h>
+
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void __libc_free(void* ptr);
+void* __libc_realloc(void* ptr, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+}
+
+// pool chunks and large blocks come from glibc directly
+#define __STL_SYSTEM_MALLOC(size) __libc_malloc(size)
+#define __STL_SYSTEM_FREE(ptr) __libc_free(ptr)
+#define __STL_SYSTEM_REALLOC(ptr, size) __libc_realloc(ptr, size)
+#define __STL_SYSTEM_ALIGNED_ALLOC(alignment, size) __libc_memalign(alignment, size)
+
+#include "stl_alloc.h"
+
+namespace {
+
+/// 16 bytes align as glibc malloc, block size is found from header
+typedef stl::size_header_alloc<stl::alloc_16_512> pool_malloc;
+
+/**
+ * @brief allocate, never throw
+ * @param[in] size alloc size
+ * @param[in] alignment memory align, zero for default
+ * */
+void* pool_allocate(std::size_t size, std::size_t alignment) {
+  try {
+    return alignment == 0 ? pool_malloc::allocate(size) : pool_malloc::allocate(size, alignment);
+  } catch (const std::bad_alloc&) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+}
+
+/**
+ * @brief check if alignment is valid for memalign family
+ * @param[in] alignment memory align
+ * */
+bool valid_alignment(std::size_t alignment) {
+  return alignment != 0 && (alignment & (alignment - 1)) == 0;
+}
+
+}
+
+extern "C" {
+
+void* malloc(std::size_t size) {
+  return pool_allocate(size, 0);
+}
+
+void free(void* ptr) {
+  if (ptr != nullptr)
+    pool_malloc::deallocate(ptr);
+}
+
+void* calloc(std::size_t count, std::size_t size) {
+  std::size_t total;
+  if (__builtin_mul_overflow(count, size, &total)) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  // reused pool block is dirty
+  void* ptr = pool_allocate(total, 0);
+  if (ptr != nullptr)
+    std::memset(ptr, 0, total);
+  return ptr;
+}
+
+void* realloc(void* ptr, std::size_t size) {
+  if (ptr != nullptr && size == 0) {
+    pool_malloc::deallocate(ptr);
+    return nullptr;
+  }
+  try {
+    return pool_malloc::reallocate(ptr, size);
+  } catch (const std::bad_alloc&) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+}
+
+int posix_memalign(void** result, std::size_t alignment, std::size_t size) {
+  if (!valid_alignment(alignment) || alignment % sizeof(void*) != 0)
+    return EINVAL;
+  void* ptr = pool_allocate(size, alignment);
+  if (ptr == nullptr)
+    return ENOMEM;
+  *result = ptr;
+  return 0;
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) {
+  if (!valid_alignment(alignment)) {
+    errno = EINVAL;
+    return nullptr;
+  }
+  return pool_allocate(size, alignment);
+}
+
+void* memalign(std::size_t alignment, std::size_t size) {
+  return aligned_alloc(alignment, size);
+}
+
+void* valloc(std::size_t size) {
+  return pool_allocate(size, ::getpagesize());
+}
+
+void* pvalloc(std::size_t size) {
+  std::size_t page = ::getpagesize();
+  if (size > std::size_t(-1) - page) {
+    errno = ENOMEM;
+    return nullptr;
+  }
+  return pool_allocate((size + page - 1) & ~(page - 1), page);
+}
+
+std::size_t malloc_usable_size(void* ptr) {
+  return ptr == nullptr ? 0 : pool_malloc::usable_size(ptr);
+}
+
+}
@@ -0,0 +1,137 @@
+// compare stl::string with std::string on short (inline) and heap lengths
+// build: g++ -std=c++17 -O2 -I../src string_bench.cpp -o string_bench
+// usage: string_bench [strings per round], default 1000
+
+#include "stl_string.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+
+namespace {
+
+/**
+ * @brief run func rounds times after one warm up, return ns per string
+ * @param[in] count strings per round
+ * @param[in] func round func
+ * */
+template<typename Func>
+double time_rounds(std::size_t count, Func func) {
+  std::size_t rounds = 2000000 / count + 1;
+  func();
+  auto begin = std::chrono::steady_clock::now();
+  for (std::size_t round = 0; round < rounds; round++)
+    func();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - begin).count() / (rounds * count);
+}
+
+/**
+ * @brief time common string operations of one type on given texts
+ * @param[in] texts source texts, same length
+ * @param[out] result ns per string of construct, copy, push_back, concat and hash lookup
+ * @param[out] check checksum, must agree between string types
+ * */
+template<typename String>
+void bench(const std::vector<std::string>& texts, double* result, std::size_t& check) {
+  std::size_t count = texts.size();
+  std::size_t length = texts[0].size();
+  std::vector<String> strings(count);
+  // construct from c string, then destroy all
+  result[0] = time_rounds(count, [&]() {
+    std::vector<String> built;
+    built.reserve(count);
+    for (const std::string& text : texts)
+      built.emplace_back(text.c_str());
+    check += built.back().size();
+  });
+  for (std::size_t index = 0; index < count; index++)
+    strings[index] = texts[index].c_str();
+  // copy construct
+  result[1] = time_rounds(count, [&]() {
+    std::vector<String> copies(strings);
+    check += copies.back().size();
+  });
+  // grow by push_back from empty
+  result[2] = time_rounds(count, [&]() {
+    for (std::size_t index = 0; index < count; index++) {
+      String grown;
+      const char* text = texts[index].c_str();
+      for (std::size_t pos = 0; pos < length; pos++)
+        grown.push_back(text[pos]);
+      check += grown[length / 2];
+    }
+  });
+  // concat two halves
+  String head(texts[0].substr(0, length / 2).c_str());
+  result[3] = time_rounds(count, [&]() {
+    for (std::size_t index = 0; index < count; index++) {
+      String joined = head + strings[index];
+      check += joined.size();
+    }
+  });
+  // hash and compare by lookup
+  std::unordered_map<String, std::size_t> table;
+  for (std::size_t index = 0; index < count; index++)
+    table[strings[index]] = index;
+  result[4] = time_rounds(count, [&]() {
+    for (std::size_t index = 0; index < count; index++)
+      check += table.find(strings[index])->second;
+  });
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  std::size_t count = 1000;
+  if (argc > 2) {
+    std::fprintf(stderr, "usage: %s [strings per round]\n", argv[0]);
+    return 1;
+  }
+  if (argc == 2)
+    count = std::strtoull(argv[1], nullptr, 10);
+  if (count == 0)
+    count = 1;
+  std::printf("sizeof stl::string %zu, std::string %zu, inline chars %zu\n", sizeof(stl::string),
+              sizeof(std::string), stl::string::local_capacity);
+  const char* names[] = { "construct", "copy", "push_back", "concat", "lookup" };
+  std::printf("%-10s %6s %12s %12s %9s\n", "op", "length", "stl ns", "std ns", "speedup");
+  // std inline 15 chars, stl inline 23 chars, then pool and malloc sizes
+  const std::size_t lengths[] = { 8, 15, 16, 23, 24, 40, 100, 200, 1000 };
+  for (std::size_t length : lengths) {
+    std::vector<std::string> texts(count);
+    for (std::size_t index = 0; index < count; index++) {
+      // distinct number first, padded to length
+      texts[index] = std::to_string(index);
+      texts[index].resize(length, char('a' + index % 26));
+    }
+    // types take turns and best of rounds is kept, so neither one always run on
+    // the heap the other just left
+    double stl_ns[5] = { 1e30, 1e30, 1e30, 1e30, 1e30 };
+    double std_ns[5] = { 1e30, 1e30, 1e30, 1e30, 1e30 };
+    for (int round = 0; round < 3; round++) {
+      double ns[2][5];
+      std::size_t stl_check = 0;
+      std::size_t std_check = 0;
+      bench<stl::string>(texts, ns[0], stl_check);
+      bench<std::string>(texts, ns[1], std_check);
+      if (stl_check != std_check) {
+        std::fprintf(stderr, "length %zu: checksum mismatch\n", length);
+        return 1;
+      }
+      for (int op = 0; op < 5; op++) {
+        stl_ns[op] = std::min(stl_ns[op], ns[0][op]);
+        std_ns[op] = std::min(std_ns[op], ns[1][op]);
+      }
+    }
+    for (int op = 0; op < 5; op++)
+      std::printf("%-10s %6zu %12.1f %12.1f %8.2fx\n", names[op], length, stl_ns[op], std_ns[op],
+                  std_ns[op] / stl_ns[op]);
+  }
+  return 0;
+}
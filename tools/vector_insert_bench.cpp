@@ -0,0 +1,165 @@
+// middle insert and erase of stl::vector against the old per element shift loop
+// build: g++ -std=c++17 -O2 -I../src vector_insert_bench.cpp -o vector_insert_bench
+// usage: vector_insert_bench [element count], default 100000
+
+#include "stl_vector.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace {
+
+// trivial 64 bytes element
+struct pod64 {
+  std::uint64_t words[8];
+};
+
+/**
+ * @brief make element from integer
+ * @param[in] value element seed
+ * */
+template<typename T>
+T make(std::size_t value);
+
+template<>
+int make<int>(std::size_t value) {
+  return int(value);
+}
+
+template<>
+pod64 make<pod64>(std::size_t value) {
+  pod64 result;
+  for (std::uint64_t& word : result.words)
+    word = value;
+  return result;
+}
+
+template<>
+std::string make<std::string>(std::size_t value) {
+  // longer than sso, so copy touches heap
+  return std::string(24, char('a' + value % 26)) + std::to_string(value);
+}
+
+/**
+ * @brief old insert, shift one by one from back, storage is preallocated
+ * @param[in] data element storage, one spare slot at end
+ * @param[in] size element count
+ * @param[in] pos insert pos
+ * @param[in] value insert value
+ * */
+template<typename T>
+void loop_insert(T* data, std::size_t size, std::size_t pos, const T& value) {
+  for (std::size_t index = size; index > pos; index--)
+    data[index] = data[index - 1];
+  data[pos] = value;
+}
+
+/**
+ * @brief old erase, shift one by one from front
+ * @param[in] data element storage
+ * @param[in] size element count
+ * @param[in] pos erase pos
+ * */
+template<typename T>
+void loop_erase(T* data, std::size_t size, std::size_t pos) {
+  for (std::size_t index = pos; index + 1 < size; index++)
+    data[index] = data[index + 1];
+}
+
+/**
+ * @brief run func rounds times after short warm up, return ns per round
+ * @param[in] rounds timed rounds
+ * @param[in] func round func
+ * */
+template<typename Func>
+double time_rounds(std::size_t rounds, Func func) {
+  for (std::size_t round = 0; round < rounds / 10 + 1; round++)
+    func();
+  auto begin = std::chrono::steady_clock::now();
+  for (std::size_t round = 0; round < rounds; round++)
+    func();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - begin).count() / rounds;
+}
+
+/**
+ * @brief time rounds of insert then erase at middle, report ns per operation
+ * @param[in] name case name
+ * @param[in] count element count
+ * @param[in] rounds insert and erase rounds
+ * */
+template<typename T>
+void bench(const char* name, std::size_t count, std::size_t rounds) {
+  T value = make<T>(count);
+  // fill all containers before timing, so no case runs on a cold heap
+  stl::vector<T> vec;
+  vec.reserve(count + 1);
+  std::vector<T> array(count + 1);
+  std::vector<T> std_vec;
+  std_vec.reserve(count + 1);
+  for (std::size_t index = 0; index < count; index++) {
+    vec.push_back(make<T>(index));
+    array[index] = make<T>(index);
+    std_vec.push_back(make<T>(index));
+  }
+  // stl::vector, bulk move
+  double stl_ns = time_rounds(rounds, [&]() {
+    vec.insert(vec.begin() + count / 2, value);
+    vec.erase(vec.begin() + count / 2);
+  }) / 2;
+  // old loop on plain array
+  double loop_ns = time_rounds(rounds, [&]() {
+    loop_insert(array.data(), count, count / 2, value);
+    loop_erase(array.data(), count + 1, count / 2);
+  }) / 2;
+  // std::vector for reference
+  double std_ns = time_rounds(rounds, [&]() {
+    std_vec.insert(std_vec.begin() + count / 2, value);
+    std_vec.erase(std_vec.begin() + count / 2);
+  }) / 2;
+  // results must agree, loop left array[count] as spare
+  for (std::size_t index = 0; index < count; index++) {
+    if (!(vec[index] == std_vec[index]) || !(array[index] == std_vec[index])) {
+      std::fprintf(stderr, "%s: result mismatch at %zu\n", name, index);
+      std::exit(1);
+    }
+  }
+  std::printf("%-8s %10zu %12.1f %12.1f %12.1f %8.2fx\n", name, count, stl_ns, loop_ns, std_ns,
+              loop_ns / stl_ns);
+}
+
+/**
+ * @brief compare pod64 by words
+ * */
+bool operator==(const pod64& a, const pod64& b) {
+  for (std::size_t index = 0; index < 8; index++) {
+    if (a.words[index] != b.words[index])
+      return false;
+  }
+  return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  std::size_t max_count = 100000;
+  if (argc > 2) {
+    std::fprintf(stderr, "usage: %s [element count]\n", argv[0]);
+    return 1;
+  }
+  if (argc == 2)
+    max_count = std::strtoull(argv[1], nullptr, 10);
+  std::printf("%-8s %10s %12s %12s %12s %9s\n", "type", "count", "stl ns", "loop ns", "std ns",
+              "speedup");
+  for (std::size_t count = 100; count <= max_count; count *= 10) {
+    std::size_t rounds = count <= 1000 ? 100000 : 10000000 / count;
+    bench<int>("int", count, rounds);
+    bench<pod64>("pod64", count, rounds);
+    bench<std::string>("string", count, rounds / 4 + 1);
+  }
+  return 0;
+}